@@ -0,0 +1,124 @@
+//==============================================================================//
+//  Filename: archive.c															//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+//																				//
+//  Loads node files already written (LHC_Sim_ID_Node*.txt) and reports the	//
+//  measures read and the throughput. With -c every file is also read with		//
+//  sscanf, line by line as before, and both results are compared.				//
+//																				//
+//  USAGE: archive [-t threads] [-c] files...									//
+//------------------------------------------------------------------------------//
+
+/* SYSTEMS INCLUDES 															*/
+//------------------------------------------------------------------------------//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/* LOCAL INCLUDES 																*/
+//------------------------------------------------------------------------------//
+#include "../include/lhc_simulator.h"
+#include "../include/lhc_archive.h"
+
+/*  ERROR MESSAGES - Program Execution											*/
+//------------------------------------------------------------------------------//
+#define FATAL(msg) \
+	do{ \
+		fprintf(stderr,"%s:%d:[%s]: %s\n", __FILE__, __LINE__, msg, strerror(errno)); \
+		exit(-1); \
+	} while (0)
+
+/** Function to know the seconds since 'begin' */
+static double seconds_Since(struct timeval *_tvBegin) {
+
+	struct timeval _tvEnd, _tvDiff;
+
+	gettimeofday(&_tvEnd, NULL);
+	time_Difference(&_tvDiff, &_tvEnd, _tvBegin);
+	return _tvDiff.tv_sec + _tvDiff.tv_usec*1e-6;
+}
+
+/** Function to read a file with sscanf and compare it with the archive. Returns the seconds
+ *  taken, and the measures that differ in 'mismatches'. */
+static double check_Archive(const char *_name, const LHC_Archive *_archive, size_t *_mismatches) {
+
+	struct timeval	_tvBegin;
+	char			_line[LHC_FORMAT_LINE_MAX+1];
+	FILE*			fp;
+	Measure			m;
+	unsigned int	i;
+	size_t			r = 0;
+	double			_seconds;
+
+	*_mismatches = 0;
+	gettimeofday(&_tvBegin, NULL);
+	fp = fopen(_name, "r");
+	if(!fp) FATAL("Opening the file");
+	while(fgets(_line, sizeof(_line), fp)) {
+		if(sscanf(_line, "%u:%d;%f;%f;%f;%f;%f;%f;%f.", &i, &m._identifier, &m._position, &m._particle_Radiation,
+				&m._particle_Speed, &m._magnet_Current, &m._helium_Temp, &m._helium_Pressure, &m._phase_RF)!=9 ||
+				r >= _archive->_number_Of_Measures ||
+				i!=_archive->_turns[r] || m._identifier!=_archive->_identifiers[r] ||
+				memcmp(&m._position, &_archive->_positions[r], sizeof(float)) ||
+				memcmp(&m._particle_Radiation, &_archive->_channels[LHC_PARTICLE_RADIATION][r], sizeof(float)) ||
+				memcmp(&m._particle_Speed, &_archive->_channels[LHC_PARTICLE_SPEED][r], sizeof(float)) ||
+				memcmp(&m._magnet_Current, &_archive->_channels[LHC_MAGNET_CURRENT][r], sizeof(float)) ||
+				memcmp(&m._helium_Temp, &_archive->_channels[LHC_HELIUM_TEMP][r], sizeof(float)) ||
+				memcmp(&m._helium_Pressure, &_archive->_channels[LHC_HELIUM_PRESSURE][r], sizeof(float)) ||
+				memcmp(&m._phase_RF, &_archive->_channels[LHC_PHASE_RF][r], sizeof(float))) (*_mismatches)++;
+		r++;
+	}
+	fclose(fp);
+	_seconds = seconds_Since(&_tvBegin);
+	if(r!=_archive->_number_Of_Measures) (*_mismatches)++;
+
+	return _seconds;
+}
+
+int main (int argc, const char * argv[]) {
+
+	struct timeval	_tvBegin;
+	struct stat		_stat;
+	LHC_Archive*	_archive;
+	unsigned int	_threads = 0;
+	int				a=1, _check = 0;
+	size_t			_bad_Line, _mismatches;
+	double			_seconds, _scanf;
+
+	for(;a<argc && argv[a][0]=='-';a++) {
+		if(strcmp(argv[a],"-t")==0 && a+1<argc && atoi(argv[a+1])>0) _threads = atoi(argv[++a]);
+		else if(strcmp(argv[a],"-c")==0) _check = 1;
+		else break;
+	}
+	if(a>=argc) {
+		fprintf(stderr, "USAGE: %s [-t threads] [-c] files...\n", argv[0]);
+		return -1;
+	}
+
+	for(;a<argc;a++) {
+		if(stat(argv[a], &_stat)!=0) FATAL(argv[a]);
+		gettimeofday(&_tvBegin, NULL);
+		_archive = load_Archive(argv[a], _threads, &_bad_Line);
+		if(!_archive && errno==EILSEQ) {
+			fprintf(stderr, "%s:%zu: not a measure.\n", argv[a], _bad_Line);
+			return -1;
+		}
+		if(!_archive) FATAL(argv[a]);
+		_seconds = seconds_Since(&_tvBegin);
+
+		printf("%s: %zu measures, %.1f MB in %.4f seconds (%.0f MB/s).\n", argv[a], _archive->_number_Of_Measures,
+				_stat.st_size/1e6, _seconds, _seconds>0 ? _stat.st_size/1e6/_seconds : 0.0);
+		if(_check) {
+			_scanf = check_Archive(argv[a], _archive, &_mismatches);
+			printf("  sscanf: %.4f seconds (x%.1f), %zu measures differ.\n", _scanf, _seconds>0 ? _scanf/_seconds : 0.0, _mismatches);
+		}
+		destroy_Archive(_archive);
+	}
+
+	return 0;
+}
@@ -0,0 +1,97 @@
+//==============================================================================//
+//  Filename: correlate.c														//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+//																				//
+//  Runs a simulation and correlates every node x channel series with all the	//
+//  others, for lags 0..max_Lag turns. The matrices are written in the binary	//
+//  format of lhc_correlation.h. The sensors follow the realistic models		//
+//  (drifts, random walks, a magnet current fault at node 0).					//
+//																				//
+//  USAGE: correlate nodes measures max_Lag [output [threads]]					//
+//------------------------------------------------------------------------------//
+
+/* SYSTEMS INCLUDES 															*/
+//------------------------------------------------------------------------------//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* LOCAL INCLUDES 																*/
+//------------------------------------------------------------------------------//
+#include "../include/lhc_simulator.h"
+#include "../include/lhc_correlation.h"
+
+/*  ERROR MESSAGES - Program Execution											*/
+//------------------------------------------------------------------------------//
+#define FATAL(msg) \
+	do{ \
+		fprintf(stderr,"%s:%d:[%s]: %s\n", __FILE__, __LINE__, msg, strerror(errno)); \
+		exit(-1); \
+	} while (0)
+
+int main (int argc, const char * argv[]) {
+
+	struct timeval 	_tvBegin, _tvEnd, _tvDiff;
+	LHC_Sim_Config	_config;
+	LHC_Sim_Results	_results;
+	LHC_Correlation* _correlation;
+	const char*		_output = (argc>4) ? argv[4] : "LHC_Correlation.bin";
+	unsigned int	_max_Lag, _lag, a, b, _best_A=0, _best_B=0, _best_Lag=0;
+	float			_best=0;
+
+	if(argc<4 || atoi(argv[1])<=0 || atoi(argv[2])<=0 || atoi(argv[3])<0) {
+		fprintf(stderr, "USAGE: %s nodes measures max_Lag [output [threads]]\n", argv[0]);
+		return -1;
+	}
+
+	lhc_Sim_Default_Config(&_config);
+	_config._number_Of_Nodes = atoi(argv[1]);
+	_config._number_Of_Measures = atoi(argv[2]);
+	_config._capture_Mode = LHC_CAPTURE_FREE;
+	_config._countdown = 0;
+	_config._verbose = 0;
+	_config._write_Files = 0;
+	realistic_Sensor_Models(_config._sensor_Model);
+	_max_Lag = atoi(argv[3]);
+
+	_config._series = create_Series(_config._number_Of_Nodes, _config._number_Of_Measures);
+	if(!_config._series) FATAL("Allocating the series");
+	if(lhc_Sim_Run(&_config, &_results)!=0) FATAL("Running the simulation");
+
+	/** Correlation of all the series */
+	gettimeofday(&_tvBegin, NULL);
+	_correlation = correlate_Series(_config._series, _max_Lag, (argc>5) ? atoi(argv[5]) : 0);
+	if(!_correlation) FATAL("Correlating the series");
+	gettimeofday(&_tvEnd, NULL);
+	time_Difference(&_tvDiff, &_tvEnd, &_tvBegin);
+
+	if(write_Correlation(_correlation, _config._series, _output)!=0) FATAL("Writing the matrices");
+
+	/** Strongest relation between two different series */
+	for(_lag=0;_lag<_correlation->_number_Of_Lags;_lag++)
+		for(a=0;a<_correlation->_number_Of_Series;a++)
+			for(b=0;b<_correlation->_number_Of_Series;b++) {
+				float _value = CORRELATION_AT(_correlation->_correlation, _correlation, _lag, a, b);
+
+				if(a!=b && fabsf(_value)>fabsf(_best)) {
+					_best = _value;
+					_best_A = a; _best_B = b; _best_Lag = _lag;
+				}
+			}
+
+	printf("%u series x %u lags over %u turns correlated in %ld.%06ld seconds -> %s\n",
+			_correlation->_number_Of_Series, _correlation->_number_Of_Lags, _correlation->_number_Of_Turns,
+			(long int)_tvDiff.tv_sec, (long int)_tvDiff.tv_usec, _output);
+	printf("Strongest: node %u %s -> node %u %s, lag %u: %f\n",
+			_best_A/LHC_CHANNELS, channel_Name(_best_A%LHC_CHANNELS),
+			_best_B/LHC_CHANNELS, channel_Name(_best_B%LHC_CHANNELS), _best_Lag, _best);
+
+	destroy_Correlation(_correlation);
+	destroy_Series(_config._series);
+
+	return 0;
+}
@@ -0,0 +1,95 @@
+//==============================================================================//
+//  Filename: hotplug.c															//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+//																				//
+//  Changes the ring while a simulation runs: a monitor is attached in the		//
+//  middle of the first sector after a quarter of the revolutions, node 1 is	//
+//  retired at half of them and another monitor replaces it. Added nodes start	//
+//  at the next revolution; their files begin at that revolution.				//
+//																				//
+//  USAGE: hotplug nodes measures [seq|free|paced]								//
+//------------------------------------------------------------------------------//
+
+/* SYSTEMS INCLUDES 															*/
+//------------------------------------------------------------------------------//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* LOCAL INCLUDES 																*/
+//------------------------------------------------------------------------------//
+#include "../include/lhc_simulator.h"
+
+/*  ERROR MESSAGES - Program Execution											*/
+//------------------------------------------------------------------------------//
+#define FATAL(msg) \
+	do{ \
+		fprintf(stderr,"%s:%d:[%s]: %s\n", __FILE__, __LINE__, msg, strerror(errno)); \
+		exit(-1); \
+	} while (0)
+
+/** Function to wait (polling every 100us) until the simulation reaches a revolution */
+static unsigned int wait_Revolution(LHC_Sim *_sim, unsigned int _revolution) {
+
+	struct timespec	_poll = { 0, 100000 };
+	unsigned int	r;
+
+	while((r = lhc_Sim_Revolution(_sim)) < _revolution) nanosleep(&_poll, NULL);
+	return r;
+}
+
+/** Function to add a node and tell what happened */
+static void add_Node(LHC_Sim *_sim, float _position) {
+
+	unsigned int r = lhc_Sim_Revolution(_sim);
+	int _identifier = lhc_Sim_Add_Node(_sim, _position);
+
+	if(_identifier<0) printf("Revolution %u: node at %.0fm not added (%s).\n", r, _position, strerror(errno));
+	else printf("Revolution %u: node %d added at %.0fm.\n", r, _identifier, _position);
+}
+
+int main (int argc, const char * argv[]) {
+
+	LHC_Sim_Config	_config;
+	LHC_Sim_Results	_results;
+	LHC_Sim*		_sim;
+	float			_sector;
+
+	if(argc<3 || atoi(argv[1])<2 || atoi(argv[2])<=0) {
+		fprintf(stderr, "USAGE: %s nodes measures [seq|free|paced]\n", argv[0]);
+		return -1;
+	}
+	lhc_Sim_Default_Config(&_config);
+	_config._number_Of_Nodes = atoi(argv[1]);
+	_config._number_Of_Measures = atoi(argv[2]);
+	_config._max_Nodes = _config._number_Of_Nodes+2;
+	_config._countdown = 0;
+	_config._verbose = 0;
+	if(argc>3 && strcmp(argv[3],"free")==0) _config._capture_Mode = LHC_CAPTURE_FREE;
+	if(argc>3 && strcmp(argv[3],"paced")==0) _config._capture_Mode = LHC_CAPTURE_PACED;
+	_sector = (float)(LHC_PERIMETER/_config._number_Of_Nodes);
+
+	_sim = lhc_Sim_Start(&_config);
+	if(!_sim) FATAL("Starting the simulation");
+
+	wait_Revolution(_sim, _config._number_Of_Measures/4);
+	add_Node(_sim, _sector/2);
+
+	printf("Revolution %u: ", wait_Revolution(_sim, _config._number_Of_Measures/2));
+	if(lhc_Sim_Remove_Node(_sim, 1)!=0) printf("node 1 not removed (%s).\n", strerror(errno));
+	else printf("node 1 removed.\n");
+	add_Node(_sim, _sector*1.5f);
+
+	if(lhc_Sim_Wait(_sim, &_results)!=0) FATAL("Running the simulation");
+
+	printf("Nodes: %u (%u added, %u removed). Measures captured: %lu. Files written: %u.\n",
+			_results._number_Of_Nodes, _results._nodes_Added, _results._nodes_Removed,
+			_results._measures_Captured, _results._files_Written);
+	printf("Elapsed execution time: %ld.%06ld seconds.\n", (long int)_results._elapsed.tv_sec, (long int)_results._elapsed.tv_usec);
+
+	return 0;
+}
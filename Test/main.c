@@ -58,7 +58,7 @@
 //	For each node, we allocate the space in memory (considering the number 		//
 //	of samples to capture) and the space required to store all the specific 	//
 //	properties regarding the node (create_Node). Once all nodes are created 	//
-//	the system waits 3 seconds before running a simulation which 'should' last 	//
+//	all of them start together running a simulation which 'should' last 		//
 //	_number_Of_Measures-times the time it takes for a set of particles to run 	//
 //	all over the LHC biggest circumference (26659m).							//
 //	After simulation is finished, each node stores all the information regarding//
@@ -86,7 +86,6 @@
 /*  LHC SIMULATOR - BASE INFORMATION											*/
 //------------------------------------------------------------------------------//
 #define NODES_MAX 16
-#define LHC_PERIMETER 26659
 
 /*  ERROR MESSAGES - Program Execution											*/
 //------------------------------------------------------------------------------//
@@ -96,32 +95,21 @@
 		exit(-1); \
 	} while (0)
 
-/*  GLOBAL VARIABLES (Present during the execution of the whole program)		*/
+/*  USAGE: LHC_Simulator [number_Of_Nodes [number_Of_Measures [seq|free|paced	*/
+/*         [telemetry_Name]]]]													*/
 //------------------------------------------------------------------------------//
-pthread_mutex_t mutex;		/** Locker for multithreading critic executions */
-int turn=0; 				/** Handles thread sequence */
-int _t_Global; 				/** Stores the time delay between nodes once defined */
+/*  Without arguments, the number of nodes is asked to the user. With a			*/
+/*  telemetry name (e.g. /lhc_telemetry) the run may be watched with monitor.	*/
+int main (int argc, const char * argv[]) {
 
-//int main (int argc, const char * argv[]) {
-int main() {
+	LHC_Sim_Config	_config;
+	LHC_Sim_Results	_results;
+	LHC_Pacing_Stats* _pacing=NULL;
+	unsigned int 	_numNodes=0, i=0;
+	unsigned int	_usual[5]={1, 2, 4, 8, 16};
+	int 			j=0;
 
-	struct timeval _tvBegin, _tvEnd, _tvDiff;
-
-	/* Clock begin */
-	if (gettimeofday(&_tvBegin, NULL)!=0)	{ 	FATAL("Get time of day. Beginning.\n");}
-	if (pthread_mutex_init(&mutex,NULL)!=0) { 	FATAL("Error Generating the 'Locking' mutex.\n ");}
-
-	unsigned int 	_numNodes, i=0;
-	int				_usual[5]={1, 2, 4, 8, 16};
-	int 			j=0, _error=0;
-	float			_delta;
-
-//	char* argv[3];
-//	argv[0] = 	"./LHC_Simulator";
-//	argv[1] = 	"2048";
-//	argv[2] = 	"1500";
-//	if(atoi(argv[1])>0) _numNodes = atoi(argv[1]);
-//	else 				_numNodes =	NODES_MAX;
+	lhc_Sim_Default_Config(&_config);
 
 	printf("*--------------------------------------------------------*\n");
 	printf("*--------- LHC - SIMULATOR - BETA VERSION v.1.0  --------*\n");
@@ -129,13 +117,24 @@ int main() {
 	printf("*..................................AUTHOR: Carlos Ciller.*\n");
 	printf("*........................................................*\n \n \n");
 
-	/** The user decides the amount of nodes to set in the LHC Simulator. */
+	/** The simulation may be scripted from the command line... */
+	if(argc>1) {
+		if(atoi(argv[1])>0) _numNodes = atoi(argv[1]);
+		else 				_numNodes =	NODES_MAX;
+		if(argc>2 && atoi(argv[2])>0) _config._number_Of_Measures = atoi(argv[2]);
+		if(argc>3 && strcmp(argv[3],"free")==0) _config._capture_Mode = LHC_CAPTURE_FREE;
+		if(argc>3 && strcmp(argv[3],"paced")==0) _config._capture_Mode = LHC_CAPTURE_PACED;
+		if(argc>4) _config._telemetry_Name = argv[4];
+		j=1;
+	}
+
+	/** ...otherwise the user decides the amount of nodes to set in the LHC Simulator. */
 	while(j==0){
 		printf("Setting the number of LHC Nodes\n");
 		printf("-------------------------------\n"),
 		printf("(In order to simplify the process select one of the following:\n ");
 		printf("1, 2, 4, 8, 16 --- Selection: ");
-		scanf("%d",&_numNodes);
+		if(scanf("%u",&_numNodes)!=1) FATAL("Reading the number of nodes");
 		for(i=0;i<5;i++){
 			if (_numNodes == _usual[i] ) {
 				printf ("You have entered %d Nodes.\n", _numNodes);
@@ -148,51 +147,31 @@ int main() {
 			printf ("***********************************************\n \n");
 		}
 	}
+	_config._number_Of_Nodes = _numNodes;
 
-	/** We initialize the vector of threads and Node identifier */
-	pthread_t       thread[_numNodes];
-	unsigned int 	_idNode[_numNodes], _aux[_numNodes];
-
-	/** We set an identifier for each LHC_Node, so it is easier to identify
-	 *  the measures related to that node. We also include the number of nodes
-	 *  so we can pass two variables (added) to each thread.*/
-	for(i=0;i<_numNodes;i++){
-		_idNode[i]=i+_numNodes*10000;
-		_aux[i]=i+_numNodes*10000;
+	/** In paced mode we want to know whether every node kept up with real time. */
+	if(_config._capture_Mode == LHC_CAPTURE_PACED) {
+		_pacing = ( LHC_Pacing_Stats* ) calloc( _numNodes, sizeof( LHC_Pacing_Stats ) );
+		if(!_pacing) FATAL("Allocating the pacing statistics");
+		_config._pacing_Stats = _pacing;
 	}
 
-	/** We set the "delta" distance between nodes. The distance between all of
-	 *  them is the same.  */
-	_delta = (float)LHC_PERIMETER/_numNodes;
-
-	/** We start the multithreading, where each thread corresponds to each node.
-	 *  The nodes keep on generating "measures" at a determinate time. Measures
-	 *  are generated sequentially between nodes, as the particle passes by. */
-	for(i=0;i<_numNodes;i++){
-		_error = pthread_create(		&thread[i],
-										NULL,
-										(void *) create_Node,
-										(void *) &_aux[i]);
-		if(_error!=0) FATAL("Error creating Thread");
-	}
+	/** The whole simulation (node threads included) runs inside the library. */
+	if(lhc_Sim_Run(&_config, &_results)!=0) FATAL("Running the simulation");
 
-	/** We destroy all threads after finishing */
-	for(i=0;i<_numNodes;i++){
-		pthread_join(		thread[i],
-							NULL);
-	}
-
-	/** We destroy the mutex we've using */
-	pthread_mutex_destroy(&mutex);
 	printf("And not a single thing was done that day! \n");
-
-	/* Clock end */
-	if(gettimeofday(&_tvEnd, NULL)!=0) FATAL("Get time of day. End.");
-
-	/* We measure the total elapsed time... */
-	time_Difference(&_tvDiff,&_tvEnd, &_tvBegin);
-
-	printf("Elapsed execution time: %ld.%06ld seconds.\n", (long int)_tvDiff.tv_sec, (long int)_tvDiff.tv_usec);
+	printf("Measures captured: %lu. Files written: %u (%s).\n", _results._measures_Captured, _results._files_Written,
+			_results._io_Uring ? "io_uring" : "blocking writes");
+	printf("Elapsed execution time: %ld.%06ld seconds.\n", (long int)_results._elapsed.tv_sec, (long int)_results._elapsed.tv_usec);
+	printf("Time to first capture: %ld.%06ld seconds (nodes ready after %ld.%06ld).\n",
+			(long int)_results._first_Capture.tv_sec, (long int)_results._first_Capture.tv_usec,
+			(long int)_results._startup.tv_sec, (long int)_results._startup.tv_usec);
+
+	if(_pacing) {
+		for(i=0;i<_numNodes;i++) print_Pacing_Stats(stdout, &_pacing[i], i);
+		print_Pacing_Stats(stdout, &_results._pacing, -1);
+		free(_pacing);
+	}
 
 	return 0;
 }
@@ -0,0 +1,101 @@
+//==============================================================================//
+//  Filename: monitor.c															//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+//																				//
+//  Live view of a running simulation. Attaches (read only) to the telemetry	//
+//  segment of lhc_telemetry.h and shows every node of the ring: last value,	//
+//  rolling mean and deviation of every channel. It never blocks the nodes.	//
+//																				//
+//  USAGE: monitor [name [period_ms]]	(default: /lhc_telemetry, 200ms)		//
+//------------------------------------------------------------------------------//
+
+/* SYSTEMS INCLUDES 															*/
+//------------------------------------------------------------------------------//
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* LOCAL INCLUDES 																*/
+//------------------------------------------------------------------------------//
+#include "../include/lhc_simulator.h"
+
+#define TELEMETRY_NAME "/lhc_telemetry"
+
+/** Function to print one screen: a line per node and a line per channel statistics. Returns
+ *  1 once the run is finished, or every node that took part is (slots never used, such as
+ *  the ones left for nodes added while it runs, do not count). */
+static int print_Ring(const LHC_Telemetry *_telemetry) {
+
+	LHC_Telemetry_Snapshot	_snapshot;
+	unsigned int			_slot, _channel, _used=0, _finished=0;
+	int64_t					_now = monotonic_Now();
+	int						_over = (__atomic_load_n(&_telemetry->_header->_state, __ATOMIC_ACQUIRE)==LHC_TELEMETRY_FINISHED);
+
+	printf("\033[H\033[2J");
+	printf("LHC telemetry (pid %d, %u nodes, %u measures per node)%s\n\n", _telemetry->_header->_pid,
+			_telemetry->_header->_number_Of_Slots, _telemetry->_header->_number_Of_Measures,
+			_over ? " - finished" : "");
+	printf("%5s %9s %10s %9s", "node", "position", "captures", "age(ms)");
+	for(_channel=0;_channel<LHC_CHANNELS;_channel++) printf(" %24s", channel_Name(_channel));
+	printf("\n");
+
+	for(_slot=0;_slot<_telemetry->_header->_number_Of_Slots;_slot++) {
+		if(read_Telemetry(_telemetry, _slot, &_snapshot)!=0) {
+			printf("%5u %9s\n", _slot, "(busy)");
+			_used++;
+			continue;
+		}
+		if(_snapshot._state==LHC_TELEMETRY_IDLE) {
+			printf("%5u %9s\n", _slot, "-");
+			continue;
+		}
+		_used++;
+		if(_snapshot._state==LHC_TELEMETRY_FINISHED) _finished++;
+
+		printf("%5u %9.1f %10u %9.1f", _snapshot._identifier, _snapshot._position, _snapshot._captures,
+				(_now - _snapshot._time)/1e6);
+		for(_channel=0;_channel<LHC_CHANNELS;_channel++)
+			printf("   %.3f (%.3f+-%.3f)", _snapshot._value[_channel], _snapshot._mean[_channel], sqrtf(_snapshot._variance[_channel]));
+		printf("\n");
+	}
+	fflush(stdout);
+
+	return _over || (_used>0 && _finished==_used);
+}
+
+int main (int argc, const char * argv[]) {
+
+	LHC_Telemetry*	_telemetry=NULL;
+	const char*		_name = (argc>1) ? argv[1] : TELEMETRY_NAME;
+	unsigned int	_period = (argc>2 && atoi(argv[2])>0) ? atoi(argv[2]) : 200;
+	struct timespec	_sleep = { _period/1000, (_period%1000)*1000000L };
+
+	/** The simulation may not have started yet */
+	while(!(_telemetry = open_Telemetry(_name))) {
+		if(errno!=ENOENT && errno!=EPROTO) {
+			fprintf(stderr, "%s: %s\n", _name, strerror(errno));
+			return -1;
+		}
+		fprintf(stderr, "\rWaiting for %s...", _name);
+		nanosleep(&_sleep, NULL);
+	}
+
+	/** Until every node is done, or the simulator is gone */
+	for(;;) {
+		if(print_Ring(_telemetry)) break;
+		if(kill(_telemetry->_header->_pid, 0)!=0 && errno==ESRCH) {
+			printf("The simulator (pid %d) is gone.\n", _telemetry->_header->_pid);
+			break;
+		}
+		nanosleep(&_sleep, NULL);
+	}
+	close_Telemetry(_telemetry);
+
+	return 0;
+}
@@ -0,0 +1,153 @@
+//==============================================================================//
+//  Filename: spectrum.c														//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+//																				//
+//  Runs a simulation tracking the beam and measures the tunes: the spectrum	//
+//  of the beam position seen by every node, over sliding windows of turns.	//
+//  The sensor channels (realistic models) go through the same stage, and the	//
+//  throughput of both analyses is reported. A step and a ramp check that rows	//
+//  which are not sinusoidal still give a line inside the spectrum.			//
+//																				//
+//  USAGE: spectrum nodes measures [window [step [threads]]]					//
+//------------------------------------------------------------------------------//
+
+/* SYSTEMS INCLUDES 															*/
+//------------------------------------------------------------------------------//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* LOCAL INCLUDES 																*/
+//------------------------------------------------------------------------------//
+#include "../include/lhc_simulator.h"
+#include "../include/lhc_spectrum.h"
+
+#define SPECTRUM_PARTICLES 1024
+
+/*  ERROR MESSAGES - Program Execution											*/
+//------------------------------------------------------------------------------//
+#define FATAL(msg) \
+	do{ \
+		fprintf(stderr,"%s:%d:[%s]: %s\n", __FILE__, __LINE__, msg, strerror(errno)); \
+		exit(-1); \
+	} while (0)
+
+/** Function to time one analysis and report its throughput */
+static LHC_Spectrum* timed_Spectrum(const char *_name, const float *_rows, unsigned int _number_Of_Rows, unsigned int _turns,
+		const LHC_Spectrum_Config *_spectrum_Config) {
+
+	struct timeval 	_tvBegin, _tvEnd, _tvDiff;
+	LHC_Spectrum*	_spectrum;
+	double			_seconds;
+
+	gettimeofday(&_tvBegin, NULL);
+	_spectrum = analyse_Spectrum(_rows, _number_Of_Rows, _turns, _spectrum_Config);
+	if(!_spectrum) FATAL("Analysing the spectrum");
+	gettimeofday(&_tvEnd, NULL);
+	time_Difference(&_tvDiff, &_tvEnd, &_tvBegin);
+	_seconds = _tvDiff.tv_sec + _tvDiff.tv_usec*1e-6;
+
+	printf("%s: %u rows x %u windows of %u turns in %.4f seconds (%.0f transforms/s).\n", _name, _spectrum->_number_Of_Rows,
+			_spectrum->_number_Of_Windows, _spectrum->_window, _seconds,
+			_seconds>0 ? (double)_spectrum->_number_Of_Rows*_spectrum->_number_Of_Windows/_seconds : 0.0);
+	return _spectrum;
+}
+
+int main (int argc, const char * argv[]) {
+
+	LHC_Sim_Config		_config;
+	LHC_Sim_Results		_results;
+	LHC_Spectrum_Config	_spectrum_Config;
+	LHC_Spectrum*		_beam;
+	LHC_Spectrum*		_channels;
+	LHC_Spectrum*		_shapes;
+	float*				_shape_Rows;
+	unsigned int		_node, _plane, _channel, _row, _outside, t, w;
+	const char*			_shape_Names[2] = { "step", "ramp" };
+
+	if(argc<3 || atoi(argv[1])<=0 || atoi(argv[2])<=0) {
+		fprintf(stderr, "USAGE: %s nodes measures [window [step [threads]]]\n", argv[0]);
+		return -1;
+	}
+
+	lhc_Sim_Default_Config(&_config);
+	_config._number_Of_Nodes = atoi(argv[1]);
+	_config._number_Of_Measures = atoi(argv[2]);
+	_config._capture_Mode = LHC_CAPTURE_FREE;
+	_config._countdown = 0;
+	_config._verbose = 0;
+	_config._write_Files = 0;
+	_config._beam._particles = SPECTRUM_PARTICLES;
+	realistic_Sensor_Models(_config._sensor_Model);
+
+	default_Spectrum_Config(&_spectrum_Config);
+	if(argc>3) _spectrum_Config._window = atoi(argv[3]);
+	if(argc>4) _spectrum_Config._step = atoi(argv[4]);
+	if(argc>5) _spectrum_Config._threads = atoi(argv[5]);
+
+	_config._series = create_Series(_config._number_Of_Nodes, _config._number_Of_Measures);
+	if(!_config._series || add_Beam_Series(_config._series)!=0) FATAL("Allocating the series");
+	if(lhc_Sim_Run(&_config, &_results)!=0) FATAL("Running the simulation");
+	printf("Lattice tunes: Qx %.4f, Qy %.4f.\n", _results._tune_X, _results._tune_Y);
+
+	_beam = timed_Spectrum("Beam", _config._series->_beam, _config._number_Of_Nodes*LHC_BEAM_PLANES,
+			_config._number_Of_Measures, &_spectrum_Config);
+	_channels = timed_Spectrum("Channels", _config._series->_data, _config._number_Of_Nodes*LHC_CHANNELS,
+			_config._number_Of_Measures, &_spectrum_Config);
+
+	/** Tune seen by every node: mean and spread of the peaks of its windows */
+	for(_node=0;_node<_config._number_Of_Nodes;_node++) {
+		printf("Node %u:", _node);
+		for(_plane=0;_plane<LHC_BEAM_PLANES;_plane++) {
+			double _sum=0, _squares=0, _amplitude=0;
+
+			for(w=0;w<_beam->_number_Of_Windows;w++) {
+				LHC_Spectrum_Peak _peak = SPECTRUM_PEAK(_beam, _node*LHC_BEAM_PLANES+_plane, w);
+
+				_sum += _peak._frequency;
+				_squares += (double)_peak._frequency*_peak._frequency;
+				_amplitude += _peak._amplitude;
+			}
+			_sum /= _beam->_number_Of_Windows;
+			printf(" q%c %.5f (+-%.1e, %.4f mm)", _plane ? 'y' : 'x', _sum,
+					sqrt(fmax(_squares/_beam->_number_Of_Windows - _sum*_sum, 0.0)), _amplitude/_beam->_number_Of_Windows);
+		}
+		printf("\n");
+	}
+
+	/** Strongest line of every channel of node 0, in its first window */
+	for(_channel=0;_channel<LHC_CHANNELS;_channel++)
+		printf("Node 0 %s: %.5f (%g)\n", channel_Name(_channel), SPECTRUM_PEAK(_channels, _channel, 0)._frequency,
+				SPECTRUM_PEAK(_channels, _channel, 0)._amplitude);
+
+	/** A unit step at turn 16 and a ramp: their strongest line must stay between 0 and 0.5
+	 *  cycles per turn in every window */
+	_shape_Rows = ( float* ) malloc( 2*(size_t)_config._number_Of_Measures*sizeof( float ) );
+	if(!_shape_Rows) FATAL("Allocating the step and the ramp");
+	for(t=0;t<_config._number_Of_Measures;t++) {
+		_shape_Rows[t] = (t>=16) ? 1.0f : 0.0f;
+		_shape_Rows[_config._number_Of_Measures+t] = (float)t/_config._number_Of_Measures;
+	}
+	_shapes = timed_Spectrum("Step/ramp", _shape_Rows, 2, _config._number_Of_Measures, &_spectrum_Config);
+	for(_row=0;_row<2;_row++) {
+		for(_outside=0, w=0;w<_shapes->_number_Of_Windows;w++) {
+			LHC_Spectrum_Peak _peak = SPECTRUM_PEAK(_shapes, _row, w);
+			if(!(_peak._frequency>=0.0f && _peak._frequency<=0.5f)) _outside++;
+		}
+		printf("%s: %.5f (%g), %u of %u windows outside the spectrum\n", _shape_Names[_row],
+				SPECTRUM_PEAK(_shapes, _row, 0)._frequency, SPECTRUM_PEAK(_shapes, _row, 0)._amplitude,
+				_outside, _shapes->_number_Of_Windows);
+	}
+
+	destroy_Spectrum(_shapes);
+	free(_shape_Rows);
+	destroy_Spectrum(_beam);
+	destroy_Spectrum(_channels);
+	destroy_Series(_config._series);
+
+	return 0;
+}
@@ -0,0 +1,192 @@
+//==============================================================================//
+//  Filename: sweep.c															//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+//																				//
+//  Parameter sweep over the LHC Simulator. Every configuration given in the	//
+//  command line is a whole simulation; they all run at the same time, spread	//
+//  over as many workers as cores (or '-j' workers), inside one single process.//
+//																				//
+//  USAGE: sweep [-j workers] [-n] [-q f32|f16|i16] [-s] [-r] nodes:measures[:mode]	//
+//	-j: amount of simulations running at the same time.							//
+//	-n: do not write the node files (only timing is reported).					//
+//	-q: precision of the channels in memory (float32, float16, scaled int16).	//
+//	-s: realistic sensor models instead of white noise.						//
+//	-r: slow channels sampled less often, and only recorded when they move.		//
+//	mode: seq, free or paced.													//
+//  Without configurations, 1, 2, 4, 8 and 16 nodes are run in both modes.		//
+//------------------------------------------------------------------------------//
+
+/* SYSTEMS INCLUDES 															*/
+//------------------------------------------------------------------------------//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* LOCAL INCLUDES 																*/
+//------------------------------------------------------------------------------//
+#include "../include/lhc_simulator.h"
+
+/*  ERROR MESSAGES - Program Execution											*/
+//------------------------------------------------------------------------------//
+#define FATAL(msg) \
+	do{ \
+		fprintf(stderr,"%s:%d:[%s]: %s\n", __FILE__, __LINE__, msg, strerror(errno)); \
+		exit(-1); \
+	} while (0)
+
+/** One simulation of the sweep */
+typedef struct _Sweep_Run{
+	LHC_Sim_Config	_config;
+	LHC_Sim_Results	_results;
+	char			_prefix[64];
+	int				_status;
+} Sweep_Run;
+
+/** Shared queue of simulations, handed to the workers one at a time */
+typedef struct _Sweep{
+	Sweep_Run*		_runs;
+	unsigned int	_number_Of_Runs;
+	unsigned int	_next;
+	pthread_mutex_t	_mutex;
+} Sweep;
+
+/** Worker: runs simulations until the queue is empty */
+static void* sweep_Worker(void *_arg) {
+
+	Sweep* 		_sweep = ( Sweep* ) _arg;
+	Sweep_Run*	_run;
+
+	for(;;) {
+		pthread_mutex_lock(&_sweep->_mutex);
+		_run = (_sweep->_next < _sweep->_number_Of_Runs) ? &_sweep->_runs[_sweep->_next++] : NULL;
+		pthread_mutex_unlock(&_sweep->_mutex);
+		if(!_run) break;
+
+		_run->_status = lhc_Sim_Run(&_run->_config, &_run->_results);
+	}
+	return NULL;
+}
+
+/** Function to read a configuration written as nodes:measures[:seq|free|paced] */
+static int parse_Run(const char *_spec, Sweep_Run *_run) {
+
+	unsigned int _nodes=0, _measures=0;
+	char _mode[8]="seq";
+
+	if(sscanf(_spec, "%u:%u:%7s", &_nodes, &_measures, _mode)<2 || _nodes==0 || _measures==0) return -1;
+	_run->_config._number_Of_Nodes = _nodes;
+	_run->_config._number_Of_Measures = _measures;
+	if(strcmp(_mode,"free")==0) 		_run->_config._capture_Mode = LHC_CAPTURE_FREE;
+	else if(strcmp(_mode,"seq")==0) 	_run->_config._capture_Mode = LHC_CAPTURE_SEQUENTIAL;
+	else if(strcmp(_mode,"paced")==0) 	_run->_config._capture_Mode = LHC_CAPTURE_PACED;
+	else return -1;
+
+	return 0;
+}
+
+int main (int argc, const char * argv[]) {
+
+	struct timeval 	_tvBegin, _tvEnd, _tvDiff;
+	Sweep			_sweep;
+	pthread_t*		_workers;
+	unsigned int	_number_Of_Workers = (unsigned int)sysconf(_SC_NPROCESSORS_ONLN), i, j;
+	unsigned int	_usual[5]={1, 2, 4, 8, 16};
+	int				_write_Files=1, _realistic=0, _multirate=0, _arg=1;
+	LHC_Precision	_precision=LHC_PRECISION_FLOAT32;
+
+	/** Options */
+	for(;_arg<argc && argv[_arg][0]=='-';_arg++) {
+		if(strcmp(argv[_arg],"-n")==0) _write_Files=0;
+		else if(strcmp(argv[_arg],"-s")==0) _realistic=1;
+		else if(strcmp(argv[_arg],"-r")==0) _multirate=1;
+		else if(strcmp(argv[_arg],"-j")==0 && _arg+1<argc) _number_Of_Workers = atoi(argv[++_arg]);
+		else if(strcmp(argv[_arg],"-q")==0 && _arg+1<argc && strcmp(argv[_arg+1],"f32")==0) { _precision = LHC_PRECISION_FLOAT32; _arg++; }
+		else if(strcmp(argv[_arg],"-q")==0 && _arg+1<argc && strcmp(argv[_arg+1],"f16")==0) { _precision = LHC_PRECISION_FLOAT16; _arg++; }
+		else if(strcmp(argv[_arg],"-q")==0 && _arg+1<argc && strcmp(argv[_arg+1],"i16")==0) { _precision = LHC_PRECISION_INT16; _arg++; }
+		else {
+			fprintf(stderr, "USAGE: %s [-j workers] [-n] [-q f32|f16|i16] [-s] [-r] nodes:measures[:seq|free|paced] ...\n", argv[0]);
+			return -1;
+		}
+	}
+	if(_number_Of_Workers==0) _number_Of_Workers=1;
+
+	/** Configurations */
+	_sweep._number_Of_Runs = (_arg<argc) ? (unsigned int)(argc-_arg) : 10;
+	_sweep._runs = ( Sweep_Run* ) calloc( _sweep._number_Of_Runs, sizeof( Sweep_Run ) );
+	if(!_sweep._runs) FATAL("Allocating the sweep");
+	_sweep._next = 0;
+
+	for(i=0;i<_sweep._number_Of_Runs;i++) {
+		Sweep_Run* _run = &_sweep._runs[i];
+
+		lhc_Sim_Default_Config(&_run->_config);
+		_run->_config._countdown = 0;
+		_run->_config._verbose = 0;
+		_run->_config._write_Files = _write_Files;
+		_run->_config._seed = i+1;
+		if(_multirate) multirate_Channel_Formats(_run->_config._channel_Format);
+		for(j=0;j<LHC_CHANNELS;j++) _run->_config._channel_Format[j]._precision = _precision;
+		if(_realistic) realistic_Sensor_Models(_run->_config._sensor_Model);
+
+		if(_arg<argc) {
+			if(parse_Run(argv[_arg+i], _run)!=0) {
+				fprintf(stderr, "Wrong configuration '%s' (nodes:measures[:seq|free|paced]).\n", argv[_arg+i]);
+				return -1;
+			}
+		} else {
+			_run->_config._number_Of_Nodes = _usual[i%5];
+			_run->_config._capture_Mode = (i<5) ? LHC_CAPTURE_SEQUENTIAL : LHC_CAPTURE_FREE;
+		}
+
+		/** Every simulation writes its own set of files */
+		snprintf(_run->_prefix, sizeof(_run->_prefix), "Sweep_%03u_%s", i, LHC_NODE_FILE_PREFIX);
+		_run->_config._output_Prefix = _run->_prefix;
+	}
+
+	if(_number_Of_Workers>_sweep._number_Of_Runs) _number_Of_Workers = _sweep._number_Of_Runs;
+	_workers = ( pthread_t* ) calloc( _number_Of_Workers, sizeof( pthread_t ) );
+	if(!_workers) FATAL("Allocating the workers");
+	if(pthread_mutex_init(&_sweep._mutex, NULL)!=0) FATAL("Error Generating the 'Locking' mutex.");
+
+	gettimeofday(&_tvBegin, NULL);
+
+	for(i=0;i<_number_Of_Workers;i++)
+		if(pthread_create(&_workers[i], NULL, sweep_Worker, &_sweep)!=0) FATAL("Error creating Thread");
+	for(i=0;i<_number_Of_Workers;i++) pthread_join(_workers[i], NULL);
+
+	gettimeofday(&_tvEnd, NULL);
+	time_Difference(&_tvDiff, &_tvEnd, &_tvBegin);
+
+	/** Report */
+	printf("  run   nodes  measures   mode  captured     files  B/measure  seconds  first(ms)  late(mean/max ns)\n");
+	for(i=0;i<_sweep._number_Of_Runs;i++) {
+		Sweep_Run* _run = &_sweep._runs[i];
+		const char* _modes[3]={"seq", "free", "paced"};
+		const LHC_Pacing_Stats* _pacing = &_run->_results._pacing;
+
+		printf("%5u %7u %9u  %5s %9lu %9u  %9.1f  %ld.%06ld  %9.3f", i,
+				_run->_config._number_Of_Nodes,
+				_run->_config._number_Of_Measures,
+				_modes[_run->_config._capture_Mode],
+				_run->_results._measures_Captured,
+				_run->_results._files_Written,
+				_run->_results._measures_Captured ? (double)_run->_results._measure_Bytes/_run->_results._measures_Captured : 0.0,
+				(long int)_run->_results._elapsed.tv_sec, (long int)_run->_results._elapsed.tv_usec,
+				_run->_results._first_Capture.tv_sec*1e3 + _run->_results._first_Capture.tv_usec*1e-3);
+		if(_pacing->_captures>0)
+			printf("  %.0f/%lld", _pacing->_lateness_Sum/_pacing->_captures, (long long)_pacing->_lateness_Max);
+		printf("%s\n", _run->_status!=0 ? "  FAILED" : "");
+	}
+	printf("Sweep of %u simulations over %u workers: %ld.%06ld seconds.\n", _sweep._number_Of_Runs,
+			_number_Of_Workers, (long int)_tvDiff.tv_sec, (long int)_tvDiff.tv_usec);
+
+	pthread_mutex_destroy(&_sweep._mutex);
+	free(_workers);
+	free(_sweep._runs);
+
+	return 0;
+}
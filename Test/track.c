@@ -0,0 +1,84 @@
+//==============================================================================//
+//  Filename: track.c															//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+//																				//
+//  Runs a simulation tracking the transverse motion of the beam through a		//
+//  FODO lattice and reports the optics and the throughput of the tracking	//
+//  (particles x turns per second). Every node records the beam it sees.		//
+//																				//
+//  USAGE: track [-t threads] [-p particles] [-f] nodes measures [seq|free|paced]	//
+//         -f writes the node files and the beam files (LHC_Sim_Beam_Node*).		//
+//------------------------------------------------------------------------------//
+
+/* SYSTEMS INCLUDES 															*/
+//------------------------------------------------------------------------------//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* LOCAL INCLUDES 																*/
+//------------------------------------------------------------------------------//
+#include "../include/lhc_simulator.h"
+
+#define TRACK_PARTICLES 4096
+
+/*  ERROR MESSAGES - Program Execution											*/
+//------------------------------------------------------------------------------//
+#define FATAL(msg) \
+	do{ \
+		fprintf(stderr,"%s:%d:[%s]: %s\n", __FILE__, __LINE__, msg, strerror(errno)); \
+		exit(-1); \
+	} while (0)
+
+int main (int argc, const char * argv[]) {
+
+	LHC_Sim_Config			_config;
+	LHC_Sim_Results			_results;
+	LHC_Lattice*			_lattice;
+	LHC_Twiss				_twiss_X, _twiss_Y;
+	double					_seconds, _tracking;
+	int						a=1;
+
+	lhc_Sim_Default_Config(&_config);
+	_config._countdown = 0;
+	_config._verbose = 0;
+	_config._write_Files = 0;
+	_config._beam._particles = TRACK_PARTICLES;
+
+	for(;a<argc && argv[a][0]=='-';a++) {
+		if(strcmp(argv[a],"-t")==0 && a+1<argc && atoi(argv[a+1])>0) _config._beam._threads = atoi(argv[++a]);
+		else if(strcmp(argv[a],"-p")==0 && a+1<argc && atoi(argv[a+1])>0) _config._beam._particles = atoi(argv[++a]);
+		else if(strcmp(argv[a],"-f")==0) _config._write_Files = 1;
+		else break;
+	}
+	if(a+1>=argc || atoi(argv[a])<=0 || atoi(argv[a+1])<=0) {
+		fprintf(stderr, "USAGE: %s [-t threads] [-p particles] [-f] nodes measures [seq|free|paced]\n", argv[0]);
+		return -1;
+	}
+	_config._number_Of_Nodes = atoi(argv[a]);
+	_config._number_Of_Measures = atoi(argv[a+1]);
+	if(a+2<argc && strcmp(argv[a+2],"free")==0) _config._capture_Mode = LHC_CAPTURE_FREE;
+	if(a+2<argc && strcmp(argv[a+2],"paced")==0) _config._capture_Mode = LHC_CAPTURE_PACED;
+
+	/** The optics the beam is matched to */
+	_lattice = create_FODO_Lattice(LHC_PERIMETER, _config._beam._cells, _config._beam._tune_X, _config._beam._tune_Y);
+	if(!_lattice || lattice_Twiss(_lattice, 0.0, &_twiss_X, &_twiss_Y)!=0) FATAL("Matching the lattice");
+	printf("%u FODO cells, %u elements: Qx %.4f, Qy %.4f, beta %.2f/%.2f m at the first node.\n", _config._beam._cells,
+			_lattice->_number_Of_Elements, _twiss_X._tune, _twiss_Y._tune, _twiss_X._beta, _twiss_Y._beta);
+	destroy_Lattice(_lattice);
+
+	if(lhc_Sim_Run(&_config, &_results)!=0) FATAL("Running the simulation");
+
+	_seconds = _results._elapsed.tv_sec + _results._elapsed.tv_usec*1e-6;
+	_tracking = _results._tracking.tv_sec + _results._tracking.tv_usec*1e-6;
+	printf("%u nodes, %u revolutions, %u particles: %.3f seconds (tracking %.3f s, %.3g particle-turns/s).\n",
+			_config._number_Of_Nodes, _config._number_Of_Measures, (_config._beam._particles+3)/4*4, _seconds, _tracking,
+			_tracking>0 ? (double)((_config._beam._particles+3)/4*4)*_config._number_Of_Measures/_tracking : 0.0);
+	if(_config._capture_Mode == LHC_CAPTURE_PACED) print_Pacing_Stats(stdout, &_results._pacing, -1);
+
+	return 0;
+}
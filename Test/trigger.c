@@ -0,0 +1,76 @@
+//==============================================================================//
+//  Filename: trigger.c															//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+//																				//
+//  Runs a simulation with the four LHC experiments as interaction points and	//
+//  reports the Level-1 trigger: events produced, events kept, rejection,		//
+//  throughput and the latency of the decisions (from the production of a		//
+//  burst to its decision, queueing included).									//
+//																				//
+//  USAGE: trigger [-w workers] [-f] measures [seq|free|paced]					//
+//         -f writes the node files and the events kept (LHC_Sim_Events.txt).	//
+//------------------------------------------------------------------------------//
+
+/* SYSTEMS INCLUDES 															*/
+//------------------------------------------------------------------------------//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* LOCAL INCLUDES 																*/
+//------------------------------------------------------------------------------//
+#include "../include/lhc_simulator.h"
+
+#define TRIGGER_NODES 4
+
+/*  ERROR MESSAGES - Program Execution											*/
+//------------------------------------------------------------------------------//
+#define FATAL(msg) \
+	do{ \
+		fprintf(stderr,"%s:%d:[%s]: %s\n", __FILE__, __LINE__, msg, strerror(errno)); \
+		exit(-1); \
+	} while (0)
+
+int main (int argc, const char * argv[]) {
+
+	LHC_Sim_Config			_config;
+	LHC_Sim_Results			_results;
+	LHC_Interaction_Point	_points[LHC_IP_MAX];
+	double					_seconds;
+	int						a=1;
+
+	lhc_Sim_Default_Config(&_config);
+	_config._number_Of_Nodes = TRIGGER_NODES;
+	_config._countdown = 0;
+	_config._verbose = 0;
+	_config._write_Files = 0;
+	_config._number_Of_Interaction_Points = default_Interaction_Points(_points);
+	_config._interaction_Points = _points;
+
+	for(;a<argc && argv[a][0]=='-';a++) {
+		if(strcmp(argv[a],"-w")==0 && a+1<argc && atoi(argv[a+1])>0) _config._trigger_Workers = atoi(argv[++a]);
+		else if(strcmp(argv[a],"-f")==0) _config._write_Files = 1;
+		else break;
+	}
+	if(a>=argc || atoi(argv[a])<=0) {
+		fprintf(stderr, "USAGE: %s [-w workers] [-f] measures [seq|free|paced]\n", argv[0]);
+		return -1;
+	}
+	_config._number_Of_Measures = atoi(argv[a]);
+	if(a+1<argc && strcmp(argv[a+1],"free")==0) _config._capture_Mode = LHC_CAPTURE_FREE;
+	if(a+1<argc && strcmp(argv[a+1],"paced")==0) _config._capture_Mode = LHC_CAPTURE_PACED;
+
+	if(lhc_Sim_Run(&_config, &_results)!=0) FATAL("Running the simulation");
+
+	_seconds = _results._elapsed.tv_sec + _results._elapsed.tv_usec*1e-6;
+	printf("%u interaction points, %u trigger workers, %u revolutions: %.3f seconds.\n",
+			_config._number_Of_Interaction_Points, _config._trigger_Workers, _config._number_Of_Measures, _seconds);
+	print_Trigger_Stats(stdout, &_results._trigger, _seconds);
+	if(_config._capture_Mode == LHC_CAPTURE_PACED) print_Pacing_Stats(stdout, &_results._pacing, -1);
+
+	return 0;
+}
@@ -0,0 +1,49 @@
+//==============================================================================//
+//  Filename: lhc_archive.h														//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+#ifndef LHC_ARCHIVE_H_
+#define LHC_ARCHIVE_H_
+
+/* System includes */
+#include <stddef.h>
+
+/* Local includes */
+#include "lhc_series.h"
+
+/*   Struct Definition   */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/* Node files already written ("%d:%d;%f;%f;%f;%f;%f;%f;%f.\n" lines, by the simulator or by
+ the original Ciller-Ruiz-Carlos.c), loaded back in memory. The file is mapped and split at
+ line boundaries into chunks parsed by several threads; the separators are found 16 bytes at
+ a time and the numbers are converted without scanf, giving the same floats as strtof. */
+
+typedef struct _LHC_Archive{
+	/** Lines of the file, one measure each. */
+	size_t _number_Of_Measures;
+
+	/** Columns (structure of arrays): index of the measure, node identifier and position,
+	 *  then every channel in the order of the line (LHC_Channel). */
+	unsigned int* _turns;
+	int* _identifiers;
+	float* _positions;
+	float* _channels[LHC_CHANNELS];
+} LHC_Archive;
+
+/*  Function definition  */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/** Function to load a node file (name, threads, first bad line). 0 threads for one per core.
+ *  NULL on failure (errno is set: EILSEQ if a line is not a measure, its number from 1 is
+ *  then kept in the last argument when not NULL). */
+LHC_Archive* load_Archive(const char *, unsigned int, size_t *);
+
+/** Function to free a loaded file. */
+void destroy_Archive(LHC_Archive *);
+
+#endif /* LHC_ARCHIVE_H_ */
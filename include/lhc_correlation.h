@@ -0,0 +1,61 @@
+//==============================================================================//
+//  Filename: lhc_correlation.h													//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+#ifndef LHC_CORRELATION_H_
+#define LHC_CORRELATION_H_
+
+/* System includes */
+#include <stdint.h>
+
+/* Local includes */
+#include "lhc_series.h"
+
+/*   Struct Definition   */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/* Lagged covariance and correlation of every pair of series (node x channel) of a run:
+ for a lag L, entry [a][b] relates a[t] with b[t+L], so a disturbance in 'a' that shows up
+ L turns later in 'b' gives a peak at [L][a][b]. Negative lags are the transposes. */
+
+/** Binary file: "LHCCORR1", then uint32 series, lags, turns, and per series its uint32 node
+ *  identifier and channel; then per lag the covariance matrix and the correlation matrix
+ *  (float32, row-major, series x series). Little-endian, as written by the host. */
+#define LHC_CORRELATION_MAGIC "LHCCORR1"
+
+typedef struct _LHC_Correlation{
+	unsigned int _number_Of_Series;
+	unsigned int _number_Of_Lags;		/** Lags 0.._number_Of_Lags-1 */
+	unsigned int _number_Of_Turns;
+
+	/** Mean and standard deviation of every series. */
+	float* _mean;
+	float* _deviation;
+
+	/** [lag][a][b] matrices. */
+	float* _covariance;
+	float* _correlation;
+} LHC_Correlation;
+
+/** Entry [lag][a][b] of one of the matrices. */
+#define CORRELATION_AT(matrix, correlation, lag, a, b) \
+	((matrix)[((size_t)(lag)*(correlation)->_number_Of_Series + (a))*(correlation)->_number_Of_Series + (b)])
+
+/*  Function definition  */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/** Function to correlate all the series of a run (series, maximum lag, threads; 0 threads
+ *  for one per core). NULL on failure (errno is set). */
+LHC_Correlation* correlate_Series(const LHC_Series *, unsigned int, unsigned int);
+
+/** Function to write the matrices in the binary format. Returns 0 or an errno. */
+int write_Correlation(const LHC_Correlation *, const LHC_Series *, const char *);
+
+/** Function to free the matrices. */
+void destroy_Correlation(LHC_Correlation *);
+
+#endif /* LHC_CORRELATION_H_ */
@@ -0,0 +1,40 @@
+//==============================================================================//
+//  Filename: lhc_format.h														//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+#ifndef LHC_FORMAT_H_
+#define LHC_FORMAT_H_
+
+/* System includes */
+#include <stddef.h>
+
+/*   Text format   */
+/*~~~~~~~~~~~~~~~~~*/
+
+/* The node files keep the historical "%d:%d;%f;%f;%f;%f;%f;%f;%f.\n" line. These functions
+ write exactly the same bytes as printf (C locale), without printf: floats are rounded to
+ 6 decimals with integer arithmetic on their exact binary value (ties to even). */
+
+/** Longest line that may be written (huge floats included), in bytes. */
+#define LHC_FORMAT_LINE_MAX 400
+
+struct _Measure;
+
+/*  Function definition  */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/** Function to write an int as "%d". Returns the amount of bytes written. */
+size_t format_Int(char *, int);
+
+/** Function to write a float as "%f". Returns the amount of bytes written. */
+size_t format_Float(char *, float);
+
+/** Function to write the line of a measure (index, measure). The destination must hold
+ *  LHC_FORMAT_LINE_MAX bytes. Returns the amount of bytes written (no '\0'). */
+size_t format_Measure_Line(char *, unsigned int, const struct _Measure *);
+
+#endif /* LHC_FORMAT_H_ */
@@ -0,0 +1,105 @@
+//==============================================================================//
+//  Filename: lhc_io.h															//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+#ifndef LHC_IO_H_
+#define LHC_IO_H_
+
+/* System includes */
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+/*   Struct Definition   */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/* One I/O engine services the files of all the nodes of a simulation. The nodes fill
+ buffers taken from a shared pool and hand them to the engine, which writes them from
+ its own thread: with io_uring (registered buffers, batched submissions and completions)
+ when the kernel allows it, and with plain blocking writes otherwise. */
+
+struct _LHC_IO_Engine;
+struct _LHC_IO_File;
+
+typedef struct _LHC_IO_Buffer{
+	/** Memory of the buffer (registered with the kernel when io_uring is used). */
+	char* _data;
+
+	/** Capacity and amount of bytes already filled in. */
+	size_t _size;
+	size_t _length;
+
+	/** Index of the buffer inside the engine pool. */
+	unsigned int _index;
+
+	/** Filled by the engine: destination and progress of the write. */
+	struct _LHC_IO_File* _file;
+	off_t _offset;
+	size_t _done;
+	struct _LHC_IO_Buffer* _next;
+} LHC_IO_Buffer;
+
+typedef struct _LHC_IO_File{
+	int _fd;
+
+	/** Offset of the next buffer handed to the engine. */
+	off_t _offset;
+
+	/** Buffers handed to the engine and not written yet. */
+	unsigned int _pending;
+
+	/** errno of the first failed write (0 if none). */
+	int _error;
+} LHC_IO_File;
+
+typedef struct _LHC_IO_Engine{
+	/** Pool of buffers (one single allocation). */
+	LHC_IO_Buffer* _buffers;
+	char* _memory;
+	unsigned int _number_Of_Buffers;
+	LHC_IO_Buffer* _free;
+
+	/** Buffers waiting to be submitted (FIFO). */
+	LHC_IO_Buffer* _queue_Head;
+	LHC_IO_Buffer* _queue_Tail;
+
+	pthread_mutex_t _mutex;
+	pthread_cond_t _work;		/** Signaled when there is something to write (or to stop). */
+	pthread_cond_t _done;		/** Signaled when a buffer is written. */
+	pthread_t _thread;
+	int _stop;
+
+	/** io_uring state (NULL when the blocking fallback is used). */
+	void* _ring;
+} LHC_IO_Engine;
+
+/*  Function definition  */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/** Function to create an engine: buffers in the pool, size of each buffer, try io_uring or not. */
+LHC_IO_Engine* create_IO_Engine(unsigned int, size_t, int);
+
+/** Function to stop the engine (pending writes are finished first) and free it. */
+void destroy_IO_Engine(LHC_IO_Engine *);
+
+/** Function to know whether the engine is using io_uring. */
+int uses_IO_Uring(const LHC_IO_Engine *);
+
+/** Function to open (create / truncate) a file for writing. NULL on failure (errno is set). */
+LHC_IO_File* open_IO_File(LHC_IO_Engine *, const char *);
+
+/** Function to wait for all the writes of a file and close it. Returns 0 or an errno. */
+int close_IO_File(LHC_IO_Engine *, LHC_IO_File *);
+
+/** Function to take an empty buffer from the pool (waits if they are all in use). */
+LHC_IO_Buffer* get_IO_Buffer(LHC_IO_Engine *);
+
+/** Function to hand a filled buffer to the engine; it is appended to the file. */
+void submit_IO_Buffer(LHC_IO_Engine *, LHC_IO_File *, LHC_IO_Buffer *);
+
+#endif /* LHC_IO_H_ */
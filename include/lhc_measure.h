@@ -0,0 +1,128 @@
+//==============================================================================//
+//  Filename: lhc_measure.h														//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+#ifndef LHC_MEASURE_H_
+#define LHC_MEASURE_H_
+
+/* System includes */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Local includes */
+#include "lhc_series.h"
+
+/*   Struct Definition   */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/* In memory, a node does not keep whole Measures: the position and identifier are kept
+ once in the node, and every sensor channel is a column with its own precision. Measures
+ are encoded on capture and decoded when read (file writing, analysis...).
+
+ Slow channels may be sampled less often than every revolution (_period, in seconds, over
+ the _cadence of the node) and only recorded when they move (_deadband). Such a channel is
+ sparse: it keeps its samples with the measure they were taken at, and a measure reads the
+ last sample taken at or before it. */
+
+/** Precision of a channel in memory. */
+typedef enum _LHC_Precision{
+	/** Exact float (4 bytes). */
+	LHC_PRECISION_FLOAT32 = 0,
+	/** IEEE half float (2 bytes, ~3 significant digits). */
+	LHC_PRECISION_FLOAT16,
+	/** Integer scaled over [_min, _max] (2 bytes, steps of (_max-_min)/65535). */
+	LHC_PRECISION_INT16
+} LHC_Precision;
+
+/** Precision requested for a channel. */
+typedef struct _LHC_Channel_Format{
+	LHC_Precision _precision;
+
+	/** Range of the values (LHC_PRECISION_INT16 only; values outside are clamped). */
+	float _min;
+	float _max;
+
+	/** Time between samples in seconds (0: every revolution). */
+	float _period;
+
+	/** A sample is only stored if it moved more than this from the last one stored (0: always). */
+	float _deadband;
+} LHC_Channel_Format;
+
+/** Column of a channel inside a node. */
+typedef struct _LHC_Channel_Store{
+	LHC_Precision _precision;
+
+	/** Values of 4 or 2 bytes: one per measure (dense), or _count samples (sparse). */
+	void* _data;
+
+	/** LHC_PRECISION_INT16: value = _min + q*_scale. */
+	float _min;
+	float _scale;
+
+	/** Sampled at the revolutions multiple of _stride, and only when the value moved more
+	 *  than _deadband from the last sample (_last). */
+	unsigned int _stride;
+	float _deadband;
+	float _last;
+
+	/** Sparse channels only (NULL otherwise): measure of every sample, and their amount. */
+	uint32_t* _turns;
+	unsigned int _count;
+} LHC_Channel_Store;
+
+struct _Measure;
+struct _LHC_Node;
+
+/*  Function definition  */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/** Function to fill the channel formats with the default (LHC_PRECISION_FLOAT32, [0,1], every
+ *  revolution). */
+void default_Channel_Formats(LHC_Channel_Format *);
+
+/** Function to sample the helium channels every 0.1s and record the speed, the helium and the
+ *  magnet current only when they move (meant for realistic_Sensor_Models). */
+void multirate_Channel_Formats(LHC_Channel_Format *);
+
+/** Function to know the bytes a channel takes per measure. */
+size_t precision_Size(LHC_Precision);
+
+/** Function to allocate the columns of a node (_number_Of_Measures and _cadence must be set)
+ *  with the given formats (one per channel), zeroed and prefaulted. Returns 0, or -1 if there
+ *  is no memory. */
+int allocate_Channels(struct _LHC_Node *, const LHC_Channel_Format *);
+
+/** Function to free the columns of a node. */
+void free_Channels(struct _LHC_Node *);
+
+/** Function to know the bytes a channel of a node takes (samples and their measures). */
+size_t channel_Bytes(const struct _LHC_Node *, LHC_Channel);
+
+/** Function to store the measure 'i' of a node (only the sensor channels are kept, and the
+ *  sparse ones only when they are due). Measures must be stored in order. */
+void encode_Measure(struct _LHC_Node *, unsigned int, const struct _Measure *);
+
+/** Function to know whether a channel of a node takes a sample at measure 'i' (every measure,
+ *  or the first one and the multiples of its stride). Nothing needs to be captured otherwise. */
+int channel_Due(const struct _LHC_Node *, LHC_Channel, unsigned int);
+
+/** Function to store the value of one channel at measure 'i' (only kept when it is due and
+ *  moved past the deadband). Measures must be stored in order. */
+void encode_Channel(struct _LHC_Node *, LHC_Channel, unsigned int, float);
+
+/** Function to read back the measure 'i' of a node (position and identifier included). */
+void decode_Measure(const struct _LHC_Node *, unsigned int, struct _Measure *);
+
+/** Function to read 'count' values of a channel from measure 'first' on, as floats. */
+void decode_Channel(const struct _LHC_Node *, LHC_Channel, unsigned int, unsigned int, float *);
+
+/** Function to convert between float and IEEE half (round to nearest even). */
+uint16_t float_To_Half(float);
+float half_To_Float(uint16_t);
+
+#endif /* LHC_MEASURE_H_ */
@@ -0,0 +1,87 @@
+//==============================================================================//
+//  Filename: lhc_pacing.h														//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+#ifndef LHC_PACING_H_
+#define LHC_PACING_H_
+
+/* System includes */
+#include <time.h>
+#include <stdio.h>
+#include <stdint.h>
+
+/*   Struct Definition   */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/* In paced mode every node captures on the wall-clock, at the instant the particle
+ reaches it: origin + revolution*period + offset. Deadlines are absolute (CLOCK_MONOTONIC),
+ so errors never accumulate from one revolution to the next. */
+
+/** Histograms are log2 buckets in ns: bucket 0 is 0ns, bucket b holds [2^(b-1), 2^b) and
+ *  the last bucket holds everything above. */
+#define LHC_PACING_BUCKETS 28
+
+typedef struct _LHC_Pacing_Stats{
+	/** Amount of captures and captures later than a whole revolution. */
+	unsigned long _captures;
+	unsigned long _missed;
+
+	/** Lateness (capture instant - deadline) in ns. */
+	int64_t _lateness_Min;
+	int64_t _lateness_Max;
+	double 	_lateness_Sum;
+
+	/** Histogram of the lateness, and of the jitter (lateness change between captures). */
+	unsigned long _lateness_Histogram[LHC_PACING_BUCKETS];
+	unsigned long _jitter_Histogram[LHC_PACING_BUCKETS];
+} LHC_Pacing_Stats;
+
+typedef struct _LHC_Pacer{
+	/** Instant of revolution 0 at the node (origin + offset), in ns. */
+	int64_t _origin;
+
+	/** Time between revolutions, in ns. */
+	double 	_period;
+
+	/** The pacer sleeps until '_spin' ns before the deadline, then spins. */
+	int64_t _spin;
+
+	/** Estimation of how late clock_nanosleep wakes up (drift compensation). */
+	int64_t _overshoot;
+
+	/** Lateness of the previous capture (for the jitter). */
+	int64_t _last_Lateness;
+
+	LHC_Pacing_Stats _stats;
+} LHC_Pacer;
+
+/*  Function definition  */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/** Function to read CLOCK_MONOTONIC in ns. */
+int64_t monotonic_Now(void);
+
+/** Function to set a pacer: origin (ns), period (ns), offset of the node (ns), spin (ns). */
+void init_Pacer(LHC_Pacer *, int64_t, double, double, int64_t);
+
+/** Function to wait for the deadline of a revolution. Returns the lateness in ns. */
+int64_t wait_Pacer(LHC_Pacer *, unsigned long);
+
+/** Function to clear / add up pacing statistics. */
+void clear_Pacing_Stats(LHC_Pacing_Stats *);
+void merge_Pacing_Stats(LHC_Pacing_Stats *, const LHC_Pacing_Stats *);
+
+/** Function to know the histogram bucket of a value in ns. */
+unsigned int pacing_Bucket(int64_t);
+
+/** Function to print a histogram of LHC_PACING_BUCKETS buckets (file, name, histogram). */
+void print_Histogram(FILE *, const char *, const unsigned long *);
+
+/** Function to print the statistics (and histograms) of a node, or of all (-1). */
+void print_Pacing_Stats(FILE *, const LHC_Pacing_Stats *, int);
+
+#endif /* LHC_PACING_H_ */
@@ -0,0 +1,95 @@
+//==============================================================================//
+//  Filename: lhc_ring.h														//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+#ifndef LHC_RING_H_
+#define LHC_RING_H_
+
+/* System includes */
+#include <stdint.h>
+
+/*   Struct Definition   */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/* Nodes may join or leave the ring while the simulation runs. The ring is never modified in
+ place: a change builds a new copy and publishes it with one atomic store, so the nodes read
+ it without locks. An old copy is freed (epoch based reclamation) only once every node that
+ could still be reading it has left its read section. */
+
+/** One member of the ring. */
+typedef struct _LHC_Ring_Member{
+	unsigned int _identifier;
+	float _position;
+} LHC_Ring_Member;
+
+/** Members sorted by position (then identifier), i.e. in the order the particle meets them. */
+typedef struct _LHC_Ring{
+	unsigned int _number_Of_Members;
+	LHC_Ring_Member _members[];
+} LHC_Ring;
+
+/** Epoch of a reader: 0 while it is not reading, otherwise the global epoch it read at its
+ *  entry. One cache line per reader. */
+typedef struct _LHC_Epoch_Reader{
+	uint64_t _epoch;
+} __attribute__((aligned(64))) LHC_Epoch_Reader;
+
+/** Object waiting to be freed. */
+typedef struct _LHC_Retired{
+	void* _object;
+	uint64_t _epoch;
+	struct _LHC_Retired* _next;
+} LHC_Retired;
+
+typedef struct _LHC_Epoch{
+	/** Global epoch (starts at 1), moved forward by every retirement. */
+	uint64_t _global;
+
+	unsigned int _number_Of_Readers;
+	LHC_Epoch_Reader* _readers;
+
+	/** Objects retired and not freed yet (writer side only). */
+	LHC_Retired* _retired;
+} LHC_Epoch;
+
+/*  Function definition  */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/** Function to create a ring with no member. Returns NULL if there is no memory. */
+LHC_Ring* create_Ring(void);
+
+/** Function to build a copy of a ring with one more member (ring, identifier, position).
+ *  Returns NULL if there is no memory. */
+LHC_Ring* insert_Ring_Member(const LHC_Ring *, unsigned int, float);
+
+/** Function to build a copy of a ring without a member. Returns NULL (errno ENOENT if the
+ *  member does not exist, ENOMEM). */
+LHC_Ring* remove_Ring_Member(const LHC_Ring *, unsigned int);
+
+/** Function to find the index of a member, or -1. */
+int find_Ring_Member(const LHC_Ring *, unsigned int);
+
+/** Function to prepare the reclamation of a set of readers (epoch, number of readers).
+ *  Returns 0, or -1 if there is no memory. */
+int init_Epoch(LHC_Epoch *, unsigned int);
+
+/** Function to free everything retired (no reader may be left) and the readers. */
+void destroy_Epoch(LHC_Epoch *);
+
+/** Function to enter / leave a read section (epoch, reader). Pointers published before the
+ *  entry stay valid until the exit. */
+void enter_Epoch(LHC_Epoch *, unsigned int);
+void exit_Epoch(LHC_Epoch *, unsigned int);
+
+/** Function to retire an object already unpublished (writers only, one at a time). Returns
+ *  0, or -1 if there is no memory (then the object is leaked rather than freed too early). */
+int retire_Epoch(LHC_Epoch *, void *);
+
+/** Function to free the retired objects no reader can see any more (writers only). */
+void collect_Epoch(LHC_Epoch *);
+
+#endif /* LHC_RING_H_ */
@@ -0,0 +1,209 @@
+//==============================================================================//
+//  Filename: lhc_sensor.h														//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+#ifndef LHC_SENSOR_H_
+#define LHC_SENSOR_H_
+
+/* System includes */
+#include <stdint.h>
+#include <pthread.h>
+
+/* Local includes */
+#include "lhc_series.h"
+
+/*   Struct Definition   */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/* Every channel of a node is generated by a sensor model. Values are produced in blocks of
+ turns (and of lanes, one lane per node), so the loops run over contiguous arrays. Random
+ numbers come from a counter-based generator: the noise of (seed, node, channel, turn) is
+ always the same, whatever the order or the batching of the generation.
+
+ A channel sampled every _stride turns is only generated at those turns: the models step
+ over the turns skipped (an AR1 takes phi^stride and the noise of the whole stride). */
+
+/** Turns generated at once by a node. */
+#define LHC_SENSOR_BLOCK 256
+
+/** No value generated yet. */
+#define LHC_SENSOR_NO_TURN 0xffffffffu
+
+/** Nodes generated together by a group. */
+#define LHC_SENSOR_LANES 8
+
+typedef enum _LHC_Sensor_Kind{
+	/** Uniform noise in [_offset, _offset+_amplitude] (the historical behaviour). */
+	LHC_SENSOR_WHITE = 0,
+	/** x[t] = _offset + _phi*(x[t-1]-_offset) + _sigma*noise (_phi=1: random walk). */
+	LHC_SENSOR_AR1,
+	/** _offset + _amplitude*sin(2pi(_frequency*t + position)) + _sigma*noise (RF phase drift). */
+	LHC_SENSOR_SINE,
+	/** From _offset towards _offset+_amplitude with time constant _tau turns, plus noise. */
+	LHC_SENSOR_THERMAL,
+	/** _offset + noise, plus _amplitude from _step_Turn on (at _step_Node, or all if -1). */
+	LHC_SENSOR_STEP
+} LHC_Sensor_Kind;
+
+typedef struct _LHC_Sensor_Model{
+	LHC_Sensor_Kind _kind;
+	float _offset;
+	float _amplitude;
+	float _sigma;			/** Standard deviation of the gaussian noise. */
+	float _phi;				/** AR1 */
+	float _frequency;		/** SINE: cycles per turn. */
+	float _tau;				/** THERMAL: turns. */
+	unsigned int _step_Turn;/** STEP */
+	int _step_Node;			/** STEP */
+} LHC_Sensor_Model;
+
+/** What a model needs to know about a node. */
+typedef struct _LHC_Sensor_Lane{
+	/** Identifier of the node (selects its random numbers). */
+	unsigned int _identifier;
+
+	/** Position of the node as a fraction of the ring [0,1). */
+	float _phase;
+
+	/** Last value of each channel (AR1), and its turn (LHC_SENSOR_NO_TURN before the first). */
+	float _state[LHC_CHANNELS];
+	unsigned int _turn[LHC_CHANNELS];
+} LHC_Sensor_Lane;
+
+/** Values of the current block of a node: turns [_first, _first+_count). A channel is only
+ *  generated at the turn _first and at the multiples of its _stride after it (its _samples
+ *  values, see sensor_Slot). */
+typedef struct _LHC_Sensor_Bank{
+	LHC_Sensor_Lane _lane;
+	unsigned int _first;
+	unsigned int _count;
+	unsigned int _stride[LHC_CHANNELS];
+	unsigned int _samples[LHC_CHANNELS];
+	float _block[LHC_CHANNELS][LHC_SENSOR_BLOCK];
+} LHC_Sensor_Bank;
+
+/** Block generated for every lane of a group. A channel holds the first turn of every lane,
+ *  then the values of each lane (lane-major, _samples-1 per lane); with a stride of 1, just
+ *  the _samples values of each lane. */
+typedef struct _LHC_Sensor_Slot{
+	/** Index of the block (its first turn over LHC_SENSOR_BLOCK), LHC_SENSOR_NO_TURN if empty. */
+	unsigned int _index;
+	unsigned int _first;
+	unsigned int _count;
+	unsigned int _samples[LHC_CHANNELS];
+
+	/** Lanes that still have to copy it. */
+	unsigned int _readers;
+
+	float _block[LHC_CHANNELS][LHC_SENSOR_LANES*LHC_SENSOR_BLOCK];
+} LHC_Sensor_Slot;
+
+/** Nodes whose sensors are generated together: one call of generate_Sensor fills a channel
+ *  of every lane, and each node copies its lane into its own bank. Two blocks are kept, so a
+ *  node may run one block ahead of the slowest lane; further on it waits for it. */
+typedef struct _LHC_Sensor_Group{
+	pthread_mutex_t _mutex;
+	pthread_cond_t _copied;
+
+	LHC_Sensor_Lane _lanes[LHC_SENSOR_LANES];
+	unsigned int _number_Of_Lanes;
+
+	/** Lanes still capturing, the next block to generate and the last block copied by each
+	 *  lane (LHC_SENSOR_NO_TURN: none). */
+	unsigned int _members;
+	unsigned int _next;
+	unsigned int _last[LHC_SENSOR_LANES];
+
+	LHC_Sensor_Slot _slots[2];
+} LHC_Sensor_Group;
+
+/*  Random numbers  */
+/*~~~~~~~~~~~~~~~~~~*/
+
+/** splitmix64 finalizer */
+static inline uint64_t splitmix64(uint64_t x) {
+
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x>>30))*0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x>>27))*0x94d049bb133111ebULL;
+	return x ^ (x>>31);
+}
+
+/** Counter-based generator: splitmix64 over (seed, node, channel, turn). The seed is mixed on
+ *  its own first: XORed raw into the counter, two seeds would only permute the same draws
+ *  (seeds s and s' giving at turn t^s^s' what the other gives at t). */
+static inline uint64_t sensor_Hash(uint64_t _seed, uint32_t _identifier, uint32_t _channel, uint32_t _turn) {
+	return splitmix64(splitmix64(_seed) ^ (((uint64_t)_identifier<<35) | ((uint64_t)_channel<<32) | _turn));
+}
+
+/** Uniform in [0,1) from the 24 high bits */
+static inline float hash_Uniform(uint64_t _hash) {
+	return (float)(_hash>>40)*(1.0f/16777216.0f);
+}
+
+/** Approximately gaussian (mean 0, deviation 1): sum of four 16-bit uniforms (Irwin-Hall),
+ *  cheap and free of branches, logarithms or trigonometry */
+static inline float hash_Gaussian(uint64_t _hash) {
+
+	uint32_t _sum = (uint32_t)(_hash & 0xffff) + (uint32_t)((_hash>>16) & 0xffff) +
+					(uint32_t)((_hash>>32) & 0xffff) + (uint32_t)(_hash>>48);
+
+	return ((float)_sum*(1.0f/65536.0f) - 2.0f)*1.7320508f;
+}
+
+/** Index in the block of a channel of the value of turn 't' (the first turn of the block, or
+ *  a multiple of the stride inside it) */
+static inline unsigned int sensor_Slot(const LHC_Sensor_Bank *_bank, unsigned int _channel, unsigned int t) {
+
+	unsigned int _stride = _bank->_stride[_channel];
+
+	if(t==_bank->_first) return 0;
+	return (t - (_bank->_first/_stride + 1)*_stride)/_stride + 1;
+}
+
+/*  Function definition  */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/** Function to set every channel to LHC_SENSOR_WHITE over [0,1]. */
+void default_Sensor_Models(LHC_Sensor_Model *);
+
+/** Function to set a plausible model per channel (drifts, random walks, an RF phase drift
+ *  and a magnet current fault at node 0). */
+void realistic_Sensor_Models(LHC_Sensor_Model *);
+
+/** Function to prepare a lane (lane, models, node identifier, position fraction). */
+void init_Sensor_Lane(LHC_Sensor_Lane *, const LHC_Sensor_Model *, unsigned int, float);
+
+/** Function to generate a channel: model, seed, lanes, number of lanes, channel, first turn,
+ *  number of values, turns between them, output (number of lanes x number of values,
+ *  lane-major). */
+void generate_Sensor(const LHC_Sensor_Model *, uint64_t, LHC_Sensor_Lane *, unsigned int,
+		LHC_Channel, unsigned int, unsigned int, unsigned int, float *);
+
+/** Function to refill the block of a bank from turn 'first' (models, seed, first, count). The
+ *  _stride of every channel must be set. */
+void fill_Sensor_Bank(LHC_Sensor_Bank *, const LHC_Sensor_Model *, uint64_t, unsigned int, unsigned int);
+
+/** Function to prepare a group of lanes (group, number of lanes). Its lanes are then set with
+ *  init_Sensor_Lane. Returns 0, or an errno. */
+int init_Sensor_Group(LHC_Sensor_Group *, unsigned int);
+
+/** Function to free a group (every lane has left). */
+void destroy_Sensor_Group(LHC_Sensor_Group *);
+
+/** Function to copy into a bank the block of a lane starting at turn 'first', a multiple of
+ *  LHC_SENSOR_BLOCK (group, lane, models, seed, first, count, bank). The first lane to need a
+ *  block generates it for all; it may wait until the slowest lane copied the block before.
+ *  The _stride of every channel of the bank must be set (the same for every lane). */
+void fetch_Sensor_Group(LHC_Sensor_Group *, unsigned int, const LHC_Sensor_Model *, uint64_t,
+		unsigned int, unsigned int, LHC_Sensor_Bank *);
+
+/** Function to take a lane out of its group once it fetches nothing more: the other lanes no
+ *  longer wait for it. */
+void leave_Sensor_Group(LHC_Sensor_Group *, unsigned int);
+
+#endif /* LHC_SENSOR_H_ */
@@ -0,0 +1,72 @@
+//==============================================================================//
+//  Filename: lhc_series.h														//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+#ifndef LHC_SERIES_H_
+#define LHC_SERIES_H_
+
+/* System includes */
+#include <stddef.h>
+
+/*   Struct Definition   */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/* The sensor channels of a Measure, in the order they are written in the node files. */
+typedef enum _LHC_Channel{
+	LHC_PARTICLE_RADIATION = 0,
+	LHC_PARTICLE_SPEED,
+	LHC_MAGNET_CURRENT,
+	LHC_HELIUM_TEMP,
+	LHC_HELIUM_PRESSURE,
+	LHC_PHASE_RF,
+	LHC_CHANNELS
+} LHC_Channel;
+
+/* Turn-by-turn values of every node x channel of a run, one contiguous row per series
+ (structure of arrays), so analysis stages stream through memory. */
+typedef struct _LHC_Series{
+	unsigned int _number_Of_Nodes;
+	unsigned int _number_Of_Turns;
+
+	/** Identifier of the node of each row group. */
+	int* _identifiers;
+
+	/** Values: row (node*LHC_CHANNELS + channel) holds _number_Of_Turns floats. */
+	float* _data;
+
+	/** Optional mean position of the beam seen by every node (mm, see add_Beam_Series):
+	 *  row (node*LHC_BEAM_PLANES + plane), x then y. NULL when not kept. */
+	float* _beam;
+} LHC_Series;
+
+#define LHC_BEAM_PLANES 2				/* Horizontal and vertical. */
+
+/** Row of a node channel. */
+#define SERIES_ROW(series, node, channel) \
+	((series)->_data + ((size_t)(node)*LHC_CHANNELS + (channel))*(series)->_number_Of_Turns)
+
+/** Row of the beam position seen by a node in a plane. */
+#define BEAM_ROW(series, node, plane) \
+	((series)->_beam + ((size_t)(node)*LHC_BEAM_PLANES + (plane))*(series)->_number_Of_Turns)
+
+/*  Function definition  */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/** Function to name a channel ("particle_Radiation"...). */
+const char* channel_Name(LHC_Channel);
+
+/** Function to allocate the series of a run (nodes, turns). NULL on failure. */
+LHC_Series* create_Series(unsigned int, unsigned int);
+
+/** Function to keep the beam positions too (filled when the run tracks the beam). Returns 0,
+ *  or -1 if there is no memory. */
+int add_Beam_Series(LHC_Series *);
+
+/** Function to free the series of a run. */
+void destroy_Series(LHC_Series *);
+
+#endif /* LHC_SERIES_H_ */
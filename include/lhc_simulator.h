@@ -26,6 +26,18 @@
 
 #include <stdint.h>
 
+/* Local includes */
+#include "lhc_pacing.h"
+#include "lhc_io.h"
+#include "lhc_format.h"
+#include "lhc_series.h"
+#include "lhc_measure.h"
+#include "lhc_sensor.h"
+#include "lhc_telemetry.h"
+#include "lhc_ring.h"
+#include "lhc_trigger.h"
+#include "lhc_tracking.h"
+
 /*   Struct Definition   */
 /*~~~~~~~~~~~~~~~~~~~~~~~*/
 
@@ -82,26 +94,318 @@ typedef struct _LHC_Node{
     /** Set the number of possible captures the node may be able to capture*/
     unsigned int _number_Of_Measures;
 
-    /** Set the time difference between a given measure and the next one.*/
+    /** Revolution of the first measure (nodes added while the simulation runs start late). */
+    unsigned int _first_Turn;
+
+    /** Set the time difference between a given measure and the next one (one revolution,
+     *  in seconds). The channels sampled less often count their period in cadences.*/
 	float _cadence;
 
-    /** Array containing the values of the measures. All included
-     *  in the previously defined Measure */
-    Measure* _measures;
+    /** Values of the measures: one column per sensor channel, each one with its
+     *  own precision (position and identifier are the ones of the node). Read and
+     *  written as Measures through decode_Measure / encode_Measure. */
+    LHC_Channel_Store _channels[LHC_CHANNELS];
+
+    /** Beam seen by the node at every measure (NULL when the beam is not tracked). */
+    LHC_Beam_Position* _beam;
 
 } LHC_Node;
 
+/*   Simulation Definition   */
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/* All the state of a simulation lives in its own context, so a process may run
+ as many simulations as it wants (one after the other or at the same time). */
+
+#define LHC_PERIMETER 26659				/* LHC biggest circumference in m. */
+#define LHC_NODE_FILE_PREFIX "LHC_Sim_ID_Node"	/* Default prefix of the node files. */
+#define LHC_EVENT_FILE "LHC_Sim_Events.txt"		/* Default file of the events kept by the trigger. */
+#define LHC_BEAM_FILE_PREFIX "LHC_Sim_Beam_Node"	/* Default prefix of the beam files. */
+
+/** Way the nodes capture their measures during a simulation. */
+typedef enum _LHC_Capture_Mode{
+	/** Nodes capture one after the other, as the particle passes by. */
+	LHC_CAPTURE_SEQUENTIAL = 0,
+	/** Every node captures on its own, without waiting for the others. */
+	LHC_CAPTURE_FREE,
+	/** Every node captures on the wall-clock, when the particle really reaches it
+	 *  (~11245 revolutions per second). */
+	LHC_CAPTURE_PACED
+} LHC_Capture_Mode;
+
+typedef struct _LHC_Sim_Config{
+	/** Amount of nodes placed along the LHC perimeter. */
+	unsigned int _number_Of_Nodes;
+
+	/** Amount of measures captured at each node. */
+	unsigned int _number_Of_Measures;
+
+	/** How the nodes are synchronized during capture. */
+	LHC_Capture_Mode _capture_Mode;
+
+	/** Seed for the sensors. Each node and channel derives its own sequence from it. */
+	unsigned int _seed;
+
+	/** Model generating every sensor channel. */
+	LHC_Sensor_Model _sensor_Model[LHC_CHANNELS];
+
+	/** Seconds to wait once all the nodes are created (0, the default, to start at once). */
+	unsigned int _countdown;
+
+	/** Write a file per node once the capture is finished (0 to skip). */
+	int _write_Files;
+
+	/** Prefix (and path) of the node files. NULL for LHC_NODE_FILE_PREFIX. */
+	const char* _output_Prefix;
+
+	/** Print the progress of the simulation on stdout (0 to keep quiet). */
+	int _verbose;
+
+	/** Paced mode: ns before each deadline the node stops sleeping and starts spinning. */
+	int64_t _pacing_Spin;
+
+	/** Paced mode: optional array (one per node slot, see _max_Nodes) receiving the
+	 *  statistics of every node. */
+	LHC_Pacing_Stats* _pacing_Stats;
+
+	/** Node files: try io_uring (0 for blocking writes), buffers in the pool and their size. */
+	int _io_Uring;
+	unsigned int _io_Buffers;
+	size_t _io_Buffer_Size;
+
+	/** Precision of every channel in memory, its sampling period and deadband. */
+	LHC_Channel_Format _channel_Format[LHC_CHANNELS];
+
+	/** Optional series (nodes x measures) receiving every channel of every node at the
+	 *  end of the run, for the analysis stages. */
+	LHC_Series* _series;
+
+	/** Optional shared memory segment (e.g. "/lhc_telemetry") where every node publishes its
+	 *  last measure and rolling statistics every _telemetry_Interval captures (0: each one). */
+	const char* _telemetry_Name;
+	unsigned int _telemetry_Interval;
+
+	/** Node slots of the simulation (0: _number_Of_Nodes). Nodes added while it runs
+	 *  (lhc_Sim_Add_Node) take the slots left; a slot is never used twice. */
+	unsigned int _max_Nodes;
+
+	/** Optional interaction points (at most LHC_IP_MAX, none by default). Each one produces a
+	 *  burst of events per revolution, on the wall-clock in paced mode and as fast as the
+	 *  trigger takes them otherwise. */
+	const LHC_Interaction_Point* _interaction_Points;
+	unsigned int _number_Of_Interaction_Points;
+
+	/** Level-1 trigger deciding the events: menu and worker threads (0 for the default). */
+	LHC_Trigger_Menu _trigger_Menu;
+	unsigned int _trigger_Workers;
+
+	/** File of the events kept (written with the node files). NULL for LHC_EVENT_FILE. */
+	const char* _event_File;
+
+	/** Transverse tracking of the beam (no particles by default). The initial nodes are its
+	 *  monitors; each node records the beam at the last monitor at or before it. */
+	LHC_Beam_Config _beam;
+
+	/** Prefix of the beam files, written with the node files. NULL for LHC_BEAM_FILE_PREFIX. */
+	const char* _beam_Prefix;
+} LHC_Sim_Config;
+
+typedef struct _LHC_Sim_Results{
+	/** Amount of nodes that took part in the simulation. */
+	unsigned int _number_Of_Nodes;
+
+	/** Nodes added and removed while the simulation was running. */
+	unsigned int _nodes_Added;
+	unsigned int _nodes_Removed;
+
+	/** Total amount of measures captured by all the nodes. */
+	unsigned long _measures_Captured;
+
+	/** Amount of node files written. */
+	unsigned int _files_Written;
+
+	/** 0 if everything went fine, otherwise the errno of the first failure. */
+	int _error;
+
+	/** Wall-clock time spent in the simulation. */
+	struct timeval _elapsed;
+
+	/** Time from the start of the simulation until every initial node was ready (the
+	 *  countdown included), and until the first measure was captured. */
+	struct timeval _startup;
+	struct timeval _first_Capture;
+
+	/** Paced mode: lateness and jitter of all the nodes together. */
+	LHC_Pacing_Stats _pacing;
+
+	/** Set if the node files were written with io_uring. */
+	int _io_Uring;
+
+	/** Bytes taken by the measures of all the nodes. */
+	size_t _measure_Bytes;
+
+	/** Events produced at the interaction points and decisions of the trigger. */
+	LHC_Trigger_Stats _trigger;
+
+	/** Time spent tracking the beam, and its tunes. */
+	struct timeval _tracking;
+	double _tune_X;
+	double _tune_Y;
+} LHC_Sim_Results;
+
+struct _LHC_Sim;
+
+#define LHC_TURN_PENDING 0xffffffffu	/* First revolution of a node not known yet. */
+#define LHC_NO_TURN 0xffffffffu			/* Nobody holds the turn. */
+
+/** Information handed to each node thread. */
+typedef struct _LHC_Node_Task{
+	/** Simulation the node belongs to. */
+	struct _LHC_Sim* _sim;
+
+	/** Identifier of the node inside the simulation (its slot). */
+	unsigned int _identifier;
+
+	/** Position of the node (m). */
+	float _position;
+
+	/** Revolution running when the node was added (0 for the initial nodes). */
+	unsigned int _added_Turn;
+
+	/** First revolution captured by the node (LHC_TURN_PENDING until it is known). In
+	 *  sequential mode it is set by the node closing the revolution before. */
+	unsigned int _first_Turn;
+
+	/** Next revolution the node will capture (read by the others, without locks). */
+	unsigned int _next_Turn;
+
+	/** Set when the node is removed: it stops before its next capture. */
+	int _retired;
+
+	/** Signaled whenever it is the turn of this node. */
+	pthread_cond_t _cond;
+
+	pthread_t _thread;
+} LHC_Node_Task;
+
+/** Information handed to each interaction point thread. */
+typedef struct _LHC_IP_Task{
+	struct _LHC_Sim* _sim;
+
+	/** Index of the interaction point, and its copy. */
+	unsigned int _index;
+	LHC_Interaction_Point _point;
+
+	pthread_t _thread;
+} LHC_IP_Task;
+
+typedef struct _LHC_Sim{
+	/** Copy of the configuration the simulation was started with. */
+	LHC_Sim_Config _config;
+
+	/** Locker for multithreading critic executions */
+	pthread_mutex_t _mutex;
+
+	/** Handles thread sequence (LHC_NO_TURN once nobody is left) */
+	unsigned int _turn;
+
+	/** Sequential mode: revolution the ring is running. */
+	unsigned int _revolution;
+
+	/** Initial nodes ready to capture: the last one sets '_started' once the countdown is over. */
+	unsigned int _ready;
+	int _started;
+
+	/** Broadcast once the simulation is started (or aborted): the barrier of the nodes and
+	 *  of the interaction points. */
+	pthread_cond_t _start;
+
+	/** CLOCK_MONOTONIC instants (ns) of lhc_Sim_Start, of the start of the capture, and of
+	 *  the first measure captured (0 until then). */
+	int64_t _begin_Time;
+	int64_t _start_Time;
+	int64_t _first_Capture;
+
+	/** Paced mode: CLOCK_MONOTONIC instant (ns) of the first revolution. */
+	int64_t _origin;
+
+	/** Set when the simulation must be cancelled (e.g. a thread was not created). */
+	int _abort;
+
+	/** One task per node slot (_max_Nodes), the first _number_Of_Tasks ones in use. */
+	LHC_Node_Task* _tasks;
+	unsigned int _number_Of_Tasks;
+
+	/** Members of the ring, read by the nodes without locks (see lhc_ring.h). Writers
+	 *  (nodes added or removed) take '_ring_Mutex', never '_mutex'. */
+	LHC_Ring* _ring;
+	LHC_Epoch _epoch;
+	pthread_mutex_t _ring_Mutex;
+
+	/** Set by lhc_Sim_Wait: no node may be added any more. */
+	int _closed;
+
+	/** Instant the simulation was started. */
+	struct timeval _begin;
+
+	/** Engine writing the files of all the nodes (NULL when no file is written). */
+	LHC_IO_Engine* _io;
+
+	/** Live telemetry segment (NULL when nothing is published). */
+	LHC_Telemetry* _telemetry;
+
+	/** Interaction points and the trigger deciding their events (NULL without them). */
+	LHC_IP_Task* _ips;
+	unsigned int _number_Of_IPs;
+	LHC_Trigger* _trigger;
+
+	/** Sensors of the initial nodes, generated LHC_SENSOR_LANES nodes at a time (node 'i' is
+	 *  lane i%LHC_SENSOR_LANES of group i/LHC_SENSOR_LANES). Added nodes generate their own. */
+	LHC_Sensor_Group* _sensor_Groups;
+	unsigned int _number_Of_Sensor_Groups;
+
+	/** Lattice of the ring and the tracking of its beam (NULL without particles). */
+	LHC_Lattice* _lattice;
+	LHC_Tracker* _tracker;
+
+	/** Shared results, updated under '_mutex'. */
+	LHC_Sim_Results _results;
+} LHC_Sim;
+
 /*  Function definition  */
 /*~~~~~~~~~~~~~~~~~~~~~~~*/
 
-/** Function to initialize a determinate node. */
-void Node(int *);
+/** Function to fill a configuration with the default values. */
+void lhc_Sim_Default_Config(LHC_Sim_Config *);
+
+/** Function to run a whole simulation. Returns 0 on success, -1 otherwise (errno is set). */
+int lhc_Sim_Run(const LHC_Sim_Config *, LHC_Sim_Results *);
+
+/** Function to start a simulation in the background. Returns its context, or NULL (errno is
+ *  set). lhc_Sim_Run is lhc_Sim_Start followed by lhc_Sim_Wait. */
+LHC_Sim* lhc_Sim_Start(const LHC_Sim_Config *);
+
+/** Function to add a node at a position (m) of a running simulation. It captures from the
+ *  next revolution on. Returns its identifier, or -1 (errno ENOSPC: no slot left, ERANGE:
+ *  no revolution left, EINVAL: the simulation is being waited for). */
+int lhc_Sim_Add_Node(LHC_Sim *, float);
+
+/** Function to remove a node of a running simulation: it stops before its next capture and
+ *  writes what it captured. Returns 0, or -1 (errno ENOENT: not in the ring). */
+int lhc_Sim_Remove_Node(LHC_Sim *, unsigned int);
+
+/** Function to know the revolution a simulation is running (the furthest node in free mode). */
+unsigned int lhc_Sim_Revolution(LHC_Sim *);
+
+/** Function to wait for the end of a simulation and free it. Returns 0 on success, -1
+ *  otherwise (errno is set). */
+int lhc_Sim_Wait(LHC_Sim *, LHC_Sim_Results *);
 
-/** Header to create Node...*/
-void create_Node(int *);
+/** Header to create Node (thread entry point, takes a LHC_Node_Task)...*/
+void* create_Node(void *);
 
 /** Header to destroy Node...*/
-void destroy_Node( LHC_Node* );
+void destroy_Node( LHC_Node*, int );
 
 /** Function to calculate the time difference between two time interval (timeval's) */
 int time_Difference(struct timeval *, struct timeval *, struct timeval *);
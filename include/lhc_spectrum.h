@@ -0,0 +1,71 @@
+//==============================================================================//
+//  Filename: lhc_spectrum.h													//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+#ifndef LHC_SPECTRUM_H_
+#define LHC_SPECTRUM_H_
+
+/* Local includes */
+#include "lhc_series.h"
+
+/*   Struct Definition   */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/* Spectrum of turn-by-turn series over sliding windows: every window is centered, weighted
+ by a Hann window and transformed, and its strongest line is kept. Frequencies are in units
+ of the revolution frequency (0..0.5), so the line of a beam position is the fractional
+ tune. The rows may be any set of series of the same length (the node x channel rows or the
+ beam rows of a LHC_Series, or the last turns of a live run). */
+
+typedef struct _LHC_Spectrum_Config{
+	/** Turns per window (a power of 2) and turns between two windows (0: the window). */
+	unsigned int _window;
+	unsigned int _step;
+
+	/** Threads (0: one per core). */
+	unsigned int _threads;
+} LHC_Spectrum_Config;
+
+/** Strongest line of a window. */
+typedef struct _LHC_Spectrum_Peak{
+	/** Frequency (revolutions), interpolated between the bins. */
+	float _frequency;
+
+	/** Amplitude of the oscillation (units of the series). */
+	float _amplitude;
+} LHC_Spectrum_Peak;
+
+typedef struct _LHC_Spectrum{
+	unsigned int _number_Of_Rows;
+	unsigned int _number_Of_Windows;
+	unsigned int _window;
+	unsigned int _step;
+
+	/** [row][window] peaks. Window w covers the turns [w*_step, w*_step+_window). */
+	LHC_Spectrum_Peak* _peaks;
+} LHC_Spectrum;
+
+/** Peak of a row at a window. */
+#define SPECTRUM_PEAK(spectrum, row, window) \
+	((spectrum)->_peaks[(size_t)(row)*(spectrum)->_number_Of_Windows + (window)])
+
+/*  Function definition  */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/** Function to fill the default configuration (windows of 1024 turns every 256, one
+ *  thread per core). */
+void default_Spectrum_Config(LHC_Spectrum_Config *);
+
+/** Function to analyse rows of turn-by-turn values (rows, number of rows, turns per row,
+ *  configuration). NULL on failure (errno EINVAL if the window is not a power of 2 or is
+ *  longer than the rows). */
+LHC_Spectrum* analyse_Spectrum(const float *, unsigned int, unsigned int, const LHC_Spectrum_Config *);
+
+/** Function to free a spectrum. */
+void destroy_Spectrum(LHC_Spectrum *);
+
+#endif /* LHC_SPECTRUM_H_ */
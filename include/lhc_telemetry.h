@@ -0,0 +1,118 @@
+//==============================================================================//
+//  Filename: lhc_telemetry.h													//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+#ifndef LHC_TELEMETRY_H_
+#define LHC_TELEMETRY_H_
+
+/* System includes */
+#include <stdint.h>
+#include <stddef.h>
+
+/* Local includes */
+#include "lhc_series.h"
+
+/*   Struct Definition   */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/* While a simulation runs, every node publishes its last measure and rolling statistics
+ in a POSIX shared memory segment (/dev/shm). Each node owns one slot guarded by a seqlock:
+ the node never waits for anybody, and readers (other processes) retry until they copy a
+ snapshot the node did not modify in the meantime. */
+
+#define LHC_TELEMETRY_MAGIC "LHCTELE1"
+
+/** Rolling statistics follow an exponential window of about this many captures. */
+#define LHC_TELEMETRY_WINDOW 1024
+
+/** State of the run (header) and of every node (slot). */
+typedef enum _LHC_Telemetry_State{
+	LHC_TELEMETRY_IDLE = 0,
+	LHC_TELEMETRY_RUNNING,
+	LHC_TELEMETRY_FINISHED
+} LHC_Telemetry_State;
+
+/** What a node publishes. */
+typedef struct _LHC_Telemetry_Snapshot{
+	uint32_t _identifier;
+	uint32_t _state;
+	float	 _position;
+
+	/** Measures captured so far, the last one being _turn. */
+	uint32_t _captures;
+	uint32_t _turn;
+
+	/** CLOCK_MONOTONIC instant of the publication (ns). */
+	int64_t	 _time;
+
+	/** Last value, rolling mean and variance, and extremes since the start of every channel. */
+	float	 _value[LHC_CHANNELS];
+	float	 _mean[LHC_CHANNELS];
+	float	 _variance[LHC_CHANNELS];
+	float	 _min[LHC_CHANNELS];
+	float	 _max[LHC_CHANNELS];
+} LHC_Telemetry_Snapshot;
+
+/** Slot of a node: odd _sequence while the node is writing. One cache line apart from the
+ *  others, so nodes do not disturb each other. */
+typedef struct _LHC_Telemetry_Slot{
+	uint32_t _sequence;
+	LHC_Telemetry_Snapshot _snapshot;
+} __attribute__((aligned(64))) LHC_Telemetry_Slot;
+
+/** Beginning of the segment, followed by _number_Of_Slots slots. */
+typedef struct _LHC_Telemetry_Header{
+	char	 _magic[8];
+	uint32_t _slot_Size;
+	uint32_t _number_Of_Slots;
+	uint32_t _number_Of_Measures;
+	uint32_t _state;
+	int32_t	 _pid;
+} __attribute__((aligned(64))) LHC_Telemetry_Header;
+
+/** A mapped segment (writer or reader side). */
+typedef struct _LHC_Telemetry{
+	LHC_Telemetry_Header* _header;
+	LHC_Telemetry_Slot* _slots;
+	size_t _size;
+	char _name[256];
+} LHC_Telemetry;
+
+struct _Measure;
+
+/*  Function definition  */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/** Function to create the segment 'name' (e.g. "/lhc_telemetry") with a slot per node
+ *  (name, slots, measures per node). A segment left by a finished or dead run is replaced.
+ *  Returns NULL and sets errno on failure (EBUSY: a running simulator publishes there). */
+LHC_Telemetry* create_Telemetry(const char *, unsigned int, unsigned int);
+
+/** Function to mark the run as finished, unmap and remove the segment (readers already
+ *  attached keep their mapping). */
+void destroy_Telemetry(LHC_Telemetry *);
+
+/** Function to attach to an existing segment, read only. Returns NULL and sets errno. */
+LHC_Telemetry* open_Telemetry(const char *);
+
+/** Function to detach from a segment opened with open_Telemetry. */
+void close_Telemetry(LHC_Telemetry *);
+
+/** Function to prepare the snapshot of a node (snapshot, identifier, position). */
+void init_Telemetry_Snapshot(LHC_Telemetry_Snapshot *, unsigned int, float);
+
+/** Function to add the measure of turn 'turn' to a snapshot (local to the node, no sharing). */
+void update_Telemetry_Snapshot(LHC_Telemetry_Snapshot *, const struct _Measure *, unsigned int);
+
+/** Function to publish a snapshot in its slot (only the node owning the slot may call it). */
+void publish_Telemetry(LHC_Telemetry *, unsigned int, const LHC_Telemetry_Snapshot *);
+
+/** Function to copy a consistent snapshot of a slot. Returns 0, or -1 (errno EAGAIN) if the
+ *  slot kept changing while it was read. */
+int read_Telemetry(const LHC_Telemetry *, unsigned int, LHC_Telemetry_Snapshot *);
+
+#endif /* LHC_TELEMETRY_H_ */
@@ -0,0 +1,161 @@
+//==============================================================================//
+//  Filename: lhc_tracking.h													//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+#ifndef LHC_TRACKING_H_
+#define LHC_TRACKING_H_
+
+/* System includes */
+#include <stdint.h>
+#include <pthread.h>
+
+/*   Struct Definition   */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/* Transverse beam dynamics: the ring is a lattice of elements (drifts, dipoles, quadrupoles)
+ with linear transfer matrices, one 2x2 matrix per plane. Macro-particles (x, x', y, y') are
+ tracked turn by turn and observed at a set of positions (the beam position monitors). As
+ everything is linear, the elements between two monitors are composed into one single map,
+ so a turn costs one map per monitor and plane, applied to four particles at once. */
+
+typedef enum _LHC_Element_Kind{
+	LHC_ELEMENT_DRIFT = 0,
+	/** Sector bend: focuses the horizontal plane by its curvature. */
+	LHC_ELEMENT_DIPOLE,
+	/** Focuses one plane and defocuses the other. */
+	LHC_ELEMENT_QUADRUPOLE
+} LHC_Element_Kind;
+
+typedef struct _LHC_Element{
+	LHC_Element_Kind _kind;
+
+	/** Length (m). */
+	double _length;
+
+	/** Dipole: bending angle (rad). Quadrupole: k (1/m^2, > 0 focuses the horizontal plane). */
+	double _strength;
+} LHC_Element;
+
+typedef struct _LHC_Lattice{
+	unsigned int _number_Of_Elements;
+	LHC_Element* _elements;
+
+	/** Circumference (m): sum of the lengths. */
+	double _length;
+} LHC_Lattice;
+
+/** Optics of one plane at a position. */
+typedef struct _LHC_Twiss{
+	double _tune;			/** Betatron oscillations per turn. */
+	double _beta;			/** m */
+	double _alpha;
+} LHC_Twiss;
+
+/** Beam seen by a monitor at one turn (mm). */
+typedef struct _LHC_Beam_Position{
+	float _mean_X;
+	float _mean_Y;
+	float _sigma_X;
+	float _sigma_Y;
+} LHC_Beam_Position;
+
+typedef struct _LHC_Beam_Config{
+	/** Macro-particles tracked (0: no tracking). Rounded up to a multiple of 4. */
+	unsigned int _particles;
+
+	/** FODO cells of the lattice (6 dipoles each) and the tunes they are matched to. */
+	unsigned int _cells;
+	double _tune_X;
+	double _tune_Y;
+
+	/** Geometric emittance of both planes (m rad). */
+	double _emittance;
+
+	/** Injection error: offset of the whole beam at the first monitor (m). */
+	double _offset_X;
+	double _offset_Y;
+
+	/** Threads tracking the particles (0: one per core). */
+	unsigned int _threads;
+} LHC_Beam_Config;
+
+typedef struct _LHC_Tracker{
+	/** One map per monitor: from it to the next one (the last one goes round the ring).
+	 *  Each map is the 2x2 matrix of x, then the one of y (row-major). */
+	unsigned int _number_Of_Monitors;
+	float* _positions;
+	double* _maps;
+
+	/** Particles (structure of arrays, m and rad). */
+	unsigned int _number_Of_Particles;
+	double* _x;
+	double* _px;
+	double* _y;
+	double* _py;
+
+	/** Beam at every turn and monitor (turn-major), valid for the first '_tracked' turns. */
+	unsigned int _number_Of_Turns;
+	LHC_Beam_Position* _table;
+	unsigned int _tracked;
+
+	/** Threads: each one owns a slice of the particles and adds up its own sums for a block
+	 *  of turns, merged at a barrier. */
+	unsigned int _number_Of_Threads;
+	pthread_t* _threads;
+	double* _sums;
+	pthread_barrier_t _barrier;
+
+	/** Readers wait on '_progress' for the turns not tracked yet. The threads wait for '_go',
+	 *  then count on it to take their slice. */
+	pthread_mutex_t _mutex;
+	pthread_cond_t _progress;
+	unsigned int _go;
+	int _stop;
+	int _finished;
+
+	/** CLOCK_MONOTONIC instants (ns) the tracking started and finished. */
+	int64_t _begin;
+	int64_t _end;
+} LHC_Tracker;
+
+/*  Function definition  */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/** Function to fill the default beam (no particles, 204 cells matched to the LHC tunes,
+ *  7 TeV emittance, small injection error). */
+void default_Beam_Config(LHC_Beam_Config *);
+
+/** Function to build a ring of FODO cells (circumference, cells, tunes). The quadrupoles are
+ *  matched to the tunes. NULL on failure (errno EDOM if no stable optics is found). */
+LHC_Lattice* create_FODO_Lattice(double, unsigned int, double, double);
+
+/** Function to free a lattice. */
+void destroy_Lattice(LHC_Lattice *);
+
+/** Function to compose the matrices from a position to another one going round the ring
+ *  (lattice, from, to, x matrix, y matrix). from == to gives the whole turn. */
+void lattice_Map(const LHC_Lattice *, double, double, double *, double *);
+
+/** Function to know the optics at a position (lattice, position, x, y). Returns 0, or -1
+ *  (errno EDOM) if the motion is not stable. */
+int lattice_Twiss(const LHC_Lattice *, double, LHC_Twiss *, LHC_Twiss *);
+
+/** Function to start tracking a beam (lattice, beam, monitor positions sorted, monitors,
+ *  turns, seed). NULL on failure (errno is set). */
+LHC_Tracker* create_Tracker(const LHC_Lattice *, const LHC_Beam_Config *, const float *, unsigned int,
+		unsigned int, uint64_t);
+
+/** Function to know the monitor a position sees: the last one at or before it. */
+unsigned int tracker_Monitor(const LHC_Tracker *, float);
+
+/** Function to wait for the beam of a turn at a monitor. NULL if the tracking stopped before. */
+const LHC_Beam_Position* wait_Tracker(LHC_Tracker *, unsigned int, unsigned int);
+
+/** Function to stop the tracking (if still running) and free it. */
+void destroy_Tracker(LHC_Tracker *);
+
+#endif /* LHC_TRACKING_H_ */
@@ -0,0 +1,173 @@
+//==============================================================================//
+//  Filename: lhc_trigger.h														//
+//										//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+#ifndef LHC_TRIGGER_H_
+#define LHC_TRIGGER_H_
+
+/* System includes */
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+
+/* Local includes */
+#include "lhc_pacing.h"
+#include "lhc_io.h"
+
+/*   Struct Definition   */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/* At the interaction points the two counter-rotating beams cross once per bunch: every
+ revolution, an interaction point produces a burst of events (one per bunch crossing, with
+ all the collisions of that crossing). Bursts go to the Level-1 trigger, a pool of worker
+ threads that keeps the few interesting events and rejects the rest before anything is
+ written. */
+
+/** Bunch slots of a revolution (25ns apart). */
+#define LHC_BUNCH_SLOTS 3564
+
+/** Interaction points a simulation may have. */
+#define LHC_IP_MAX 8
+
+typedef struct _LHC_Interaction_Point{
+	/** Position on the ring (m). */
+	float _position;
+
+	/** Bunch crossings per revolution (filled bunches, at most LHC_BUNCH_SLOTS). */
+	unsigned int _bunches;
+
+	/** Mean collisions per crossing (pile-up). */
+	float _pile_Up;
+} LHC_Interaction_Point;
+
+/** Level-1 menu: an event is kept if any of its conditions holds. */
+typedef struct _LHC_Trigger_Menu{
+	/** Total transverse energy above this (GeV). */
+	float _et_Threshold;
+
+	/** Hardest muon above this transverse momentum (GeV). */
+	float _muon_Threshold;
+
+	/** One crossing out of _prescale is kept whatever it contains (0: none). */
+	unsigned int _prescale;
+} LHC_Trigger_Menu;
+
+/** Bits of LHC_Event::_trigger, the conditions an event passed. */
+#define LHC_TRIGGER_ET 1
+#define LHC_TRIGGER_MUON 2
+#define LHC_TRIGGER_PRESCALE 4
+
+/** One bunch crossing. */
+typedef struct _LHC_Event{
+	uint32_t _turn;
+	uint16_t _crossing;
+	uint8_t	 _ip;
+	uint8_t	 _muons;
+	uint16_t _collisions;
+	uint16_t _trigger;
+	float	 _sum_Et;
+	float	 _muon_Pt;
+	float	 _missing_Et;
+} LHC_Event;
+
+/** Events of one interaction point and one revolution. */
+typedef struct _LHC_Burst{
+	/** CLOCK_MONOTONIC instant the burst was produced (ns). */
+	int64_t _time;
+
+	unsigned int _ip;
+	unsigned int _number_Of_Events;
+	LHC_Event* _events;
+	struct _LHC_Burst* _next;
+} LHC_Burst;
+
+typedef struct _LHC_Trigger_Stats{
+	/** Bursts and events seen, events kept (in total and by condition). */
+	unsigned long _bursts;
+	unsigned long _events;
+	unsigned long _accepted;
+	unsigned long _accepted_Et;
+	unsigned long _accepted_Muon;
+	unsigned long _accepted_Prescale;
+
+	/** Latency of every burst, from its production to its decision (ns). */
+	int64_t _latency_Min;
+	int64_t _latency_Max;
+	double	_latency_Sum;
+	unsigned long _latency_Histogram[LHC_PACING_BUCKETS];
+
+	/** Time the workers spent deciding (ns, all workers together). */
+	double	_decision_Time;
+} LHC_Trigger_Stats;
+
+typedef struct _LHC_Trigger{
+	LHC_Trigger_Menu _menu;
+
+	/** Pool of bursts (one single allocation of events). */
+	LHC_Burst* _bursts;
+	LHC_Event* _memory;
+	unsigned int _number_Of_Bursts;
+	LHC_Burst* _free;
+
+	/** Bursts waiting for a decision (FIFO). */
+	LHC_Burst* _queue_Head;
+	LHC_Burst* _queue_Tail;
+
+	pthread_mutex_t _mutex;
+	pthread_cond_t _work;		/** Signaled when a burst is queued (or to stop). */
+	pthread_cond_t _done;		/** Signaled when a burst is back in the pool. */
+	pthread_t* _workers;
+	unsigned int _number_Of_Workers;
+	int _stop;
+
+	/** Kept events are written through the I/O engine into one single file (none when _io
+	 *  is NULL). Every worker fills its own buffer. */
+	LHC_IO_Engine* _io;
+	LHC_IO_File* _file;
+
+	/** Statistics of the workers, merged when they stop. */
+	LHC_Trigger_Stats _stats;
+} LHC_Trigger;
+
+/*  Function definition  */
+/*~~~~~~~~~~~~~~~~~~~~~~~*/
+
+/** Function to fill the four LHC experiments (ATLAS, ALICE, CMS, LHCb). Returns how many. */
+unsigned int default_Interaction_Points(LHC_Interaction_Point *);
+
+/** Function to fill the default menu. */
+void default_Trigger_Menu(LHC_Trigger_Menu *);
+
+/** Function to produce the burst of an interaction point at a revolution (interaction point,
+ *  its index, seed, revolution, burst). The events only depend on the arguments. */
+void generate_Collisions(const LHC_Interaction_Point *, unsigned int, uint64_t, unsigned int, LHC_Burst *);
+
+/** Function to start a trigger (menu, workers, bursts in the pool, and optionally the engine
+ *  and the file of kept events). Each worker holds one buffer of the engine while it runs.
+ *  NULL on failure (errno is set). */
+LHC_Trigger* create_Trigger(const LHC_Trigger_Menu *, unsigned int, unsigned int, LHC_IO_Engine *, const char *);
+
+/** Function to take an empty burst (waits if the workers are behind). */
+LHC_Burst* get_Trigger_Burst(LHC_Trigger *);
+
+/** Function to hand a burst to the workers. */
+void submit_Trigger_Burst(LHC_Trigger *, LHC_Burst *);
+
+/** Function to decide the bursts left, stop the workers and free the trigger (NULL is fine).
+ *  The statistics are copied (if not NULL). Returns 0, or the errno of the first failed write. */
+int destroy_Trigger(LHC_Trigger *, LHC_Trigger_Stats *);
+
+/** Function to keep the events of a burst passing the menu (moved to the front). Returns
+ *  how many were kept. */
+unsigned int decide_Burst(const LHC_Trigger_Menu *, LHC_Burst *);
+
+/** Function to clear / add up / print trigger statistics (file, stats, seconds of the run). */
+void clear_Trigger_Stats(LHC_Trigger_Stats *);
+void merge_Trigger_Stats(LHC_Trigger_Stats *, const LHC_Trigger_Stats *);
+void print_Trigger_Stats(FILE *, const LHC_Trigger_Stats *, double);
+
+#endif /* LHC_TRIGGER_H_ */
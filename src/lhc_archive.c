@@ -0,0 +1,392 @@
+//==============================================================================//
+//  Filename: lhc_archive.c														//
+//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+/* Local includes */
+#include "../include/lhc_archive.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <float.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ARCHIVE_FIELDS 9				/* i:id;pos; and the 6 channels */
+#define ARCHIVE_MIN_CHUNK (256*1024)	/* Bytes below which a file is not split further. */
+#define ARCHIVE_CHUNKS 4				/* Chunks per thread, so the faster threads take more. */
+#define ARCHIVE_FIELD_MAX 512			/* Longest number handed to strtof. */
+
+/** Sixteen bytes compared at once (SSE / NEON, or whatever the compiler targets) */
+typedef signed char v16c __attribute__((vector_size(16)));
+
+/** Separator expected at the end of every field of a line */
+static const char _separators[ARCHIVE_FIELDS] = { ':', ';', ';', ';', ';', ';', ';', ';', '\n' };
+
+/** Powers of ten exact in double */
+static const double _powers[23] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/** Part of the file parsed by one thread: it starts at a line and ends after one */
+typedef struct _Archive_Chunk{
+	const char*	_begin;
+	const char*	_end;
+
+	/** Lines of the chunk and index of its first one in the file */
+	size_t		_lines;
+	size_t		_first;
+
+	/** First bad line of the chunk (from 1), 0 if none */
+	size_t		_bad_Line;
+} Archive_Chunk;
+
+/** Work shared by the threads: the chunks are counted, then parsed */
+typedef struct _Archive_Job{
+	LHC_Archive*	_archive;
+	Archive_Chunk*	_chunks;
+	unsigned int	_number_Of_Chunks;
+	unsigned int	_next;
+	int				_parse;
+} Archive_Job;
+
+
+/*  SCANNING  */
+/*~~~~~~~~~~~~*/
+/** Function to load up to 16 bytes (the ones past 'n' are zero) */
+static inline v16c load_V16(const char *_p, size_t n) {
+
+	v16c _v = { 0 };
+
+	memcpy(&_v, _p, n<16 ? n : 16);
+	return _v;
+}
+
+/** Function to turn a comparison (0 / -1 bytes) into one bit per byte */
+static inline unsigned int mask_V16(v16c _v) {
+
+	uint64_t _half[2];
+
+	memcpy(_half, &_v, sizeof(_half));
+	/** The top bit of every byte is moved to the top byte by one multiplication */
+	return (unsigned int)((((_half[0] & 0x8080808080808080ULL)*0x0002040810204081ULL) >> 56) |
+			((((_half[1] & 0x8080808080808080ULL)*0x0002040810204081ULL) >> 56) << 8));
+}
+
+/** Function to count the lines of a chunk (the last one may have no '\n') */
+static size_t count_Lines(const char *_begin, const char *_end) {
+
+	const v16c		_newline = { '\n','\n','\n','\n','\n','\n','\n','\n','\n','\n','\n','\n','\n','\n','\n','\n' };
+	const char*		p = _begin;
+	size_t			_lines = 0;
+	unsigned int	i, j;
+
+	while(_end - p >= 16) {
+		v16c _count = { 0 };
+
+		/** Every lane counts up to 255 before it is added up */
+		for(i=0;i<255 && _end - p >= 16;i++, p+=16) _count -= (load_V16(p, 16) == _newline);
+		for(j=0;j<16;j++) _lines += (unsigned char)_count[j];
+	}
+	for(;p<_end;p++) _lines += (*p=='\n');
+	if(_end>_begin && _end[-1]!='\n') _lines++;
+
+	return _lines;
+}
+
+
+/*  NUMBERS  */
+/*~~~~~~~~~~~*/
+/** Function to read an int ("%d"). Returns 0, or -1 if the field is not one. */
+static int parse_Int(const char *p, const char *_end, long _min, long _max, long *_value) {
+
+	long	v = 0;
+	int		_negative = (p<_end && *p=='-');
+
+	p += _negative;
+	if(p==_end || _end-p > 10) return -1;
+	for(;p<_end;p++) {
+		if((unsigned char)(*p-'0') > 9) return -1;
+		v = v*10 + (*p-'0');
+	}
+	if(_negative) v = -v;
+	if(v<_min || v>_max) return -1;
+	*_value = v;
+
+	return 0;
+}
+
+/** Function to read a float with strtof (anything the fast path does not take) */
+static int parse_Float_Slow(const char *p, const char *_end, float *_value) {
+
+	char	_field[ARCHIVE_FIELD_MAX];
+	char*	_last;
+
+	if(p==_end || _end-p >= ARCHIVE_FIELD_MAX) return -1;
+	memcpy(_field, p, _end-p);
+	_field[_end-p] = '\0';
+	*_value = strtof(_field, &_last);
+
+	return (_last == _field + (_end-p)) ? 0 : -1;
+}
+
+/** Function to read a float ("%f"). The digits are an exact integer and the decimals an exact
+ *  power of ten, so one division in double rounds once; rounding it to float gives the float of
+ *  strtof, except when the double falls right between two floats (then strtof decides).
+ *  Returns 0, or -1 if the field is not a number. */
+static int parse_Float(const char *p, const char *_end, float *_value) {
+
+	const char*	_begin = p;
+	uint64_t	m = 0, _bits;
+	int			_negative = (p<_end && *p=='-'), _digits = 0, _decimals = 0;
+	double		d;
+	float		f;
+
+	p += _negative;
+	for(;p<_end && (unsigned char)(*p-'0') <= 9;p++, _digits++) m = m*10 + (*p-'0');
+	if(p<_end && *p=='.')
+		for(p++;p<_end && (unsigned char)(*p-'0') <= 9;p++, _digits++, _decimals++) m = m*10 + (*p-'0');
+	if(p!=_end || _digits==0 || _digits>15 || _decimals>22) return parse_Float_Slow(_begin, _end, _value);
+
+	d = (double)m/_powers[_decimals];
+	f = (float)d;
+	memcpy(&_bits, &d, sizeof(_bits));
+	if(d!=0 && (d < FLT_MIN || d > FLT_MAX || (_bits & 0x1fffffffULL)==0x10000000ULL))
+		return parse_Float_Slow(_begin, _end, _value);
+	*_value = _negative ? -f : f;
+
+	return 0;
+}
+
+/** Function to store field 'f' of measure 'r'. Returns 0, or -1 if it is not a number. */
+static int parse_Field(LHC_Archive *_archive, size_t r, unsigned int f, const char *p, const char *_end) {
+
+	long v;
+
+	switch(f) {
+	case 0:
+		if(parse_Int(p, _end, 0, UINT_MAX, &v)!=0) return -1;
+		_archive->_turns[r] = (unsigned int)v;
+		return 0;
+	case 1:
+		if(parse_Int(p, _end, INT_MIN, INT_MAX, &v)!=0) return -1;
+		_archive->_identifiers[r] = (int)v;
+		return 0;
+	case 2:
+		return parse_Float(p, _end, &_archive->_positions[r]);
+	case ARCHIVE_FIELDS-1:
+		/** The line ends with '.' */
+		if(_end==p || _end[-1]!='.') return -1;
+		_end--;
+		/* fall through */
+	default:
+		return parse_Float(p, _end, &_archive->_channels[f-3][r]);
+	}
+}
+
+/** Function to parse the lines of a chunk: the separators of 16 bytes are found at once, then
+ *  every field between two of them is converted */
+static void parse_Chunk(LHC_Archive *_archive, Archive_Chunk *_chunk) {
+
+	const v16c		_colon = { ':',':',':',':',':',':',':',':',':',':',':',':',':',':',':',':' };
+	const v16c		_semicolon = { ';',';',';',';',';',';',';',';',';',';',';',';',';',';',';',';' };
+	const v16c		_newline = { '\n','\n','\n','\n','\n','\n','\n','\n','\n','\n','\n','\n','\n','\n','\n','\n' };
+	const char*		p = _chunk->_begin;
+	const char*		_field = p;
+	const char*		_end = _chunk->_end;
+	size_t			r = _chunk->_first, _line = 0;
+	unsigned int	f = 0, _mask;
+
+	for(;p<_end;p+=16) {
+		size_t	n = (size_t)(_end-p);
+		v16c	_v = load_V16(p, n);
+
+		_mask = mask_V16((_v == _colon) | (_v == _semicolon) | (_v == _newline));
+		if(n<16) _mask &= (1u<<n)-1;
+
+		while(_mask) {
+			const char* _separator = p + __builtin_ctz(_mask);
+
+			_mask &= _mask-1;
+			if(*_separator!=_separators[f] || parse_Field(_archive, r, f, _field, _separator)!=0) {
+				_chunk->_bad_Line = _line+1;
+				return;
+			}
+			_field = _separator+1;
+			if(++f==ARCHIVE_FIELDS) {
+				f = 0;
+				r++;
+				_line++;
+			}
+		}
+	}
+
+	/** The last line of the file may have no '\n' */
+	if(_field<_end && (f!=ARCHIVE_FIELDS-1 || parse_Field(_archive, r, f, _field, _end)!=0)) _chunk->_bad_Line = _line+1;
+	else if(_field==_end && f!=0) _chunk->_bad_Line = _line+1;
+}
+
+/** Thread: takes chunks until there is none left, to count or to parse them */
+static void* archive_Worker(void *_arg) {
+
+	Archive_Job*	_job = ( Archive_Job* ) _arg;
+	unsigned int	i;
+
+	while((i = __atomic_fetch_add(&_job->_next, 1, __ATOMIC_RELAXED)) < _job->_number_Of_Chunks) {
+		Archive_Chunk* _chunk = &_job->_chunks[i];
+
+		if(_job->_parse) parse_Chunk(_job->_archive, _chunk);
+		else _chunk->_lines = count_Lines(_chunk->_begin, _chunk->_end);
+	}
+	return NULL;
+}
+
+/** Function to run a pass over all the chunks with the threads (the caller is one of them) */
+static void run_Archive_Job(Archive_Job *_job, unsigned int _threads) {
+
+	pthread_t*		_thread = ( pthread_t* ) calloc( _threads, sizeof( pthread_t ) );
+	unsigned int	i, _created=0;
+
+	/** Without room for the threads, the caller does it all */
+	_job->_next = 0;
+	for(i=1;_thread && i<_threads;i++) {
+		if(pthread_create(&_thread[i], NULL, archive_Worker, _job)!=0) break;
+		_created++;
+	}
+	archive_Worker(_job);
+	for(i=1;i<=_created;i++) pthread_join(_thread[i], NULL);
+	free(_thread);
+}
+
+
+/*  ARCHIVE  */
+/*~~~~~~~~~~~*/
+void destroy_Archive(LHC_Archive *_archive) {
+
+	unsigned int _channel;
+
+	if(!_archive) return;
+	free(_archive->_turns);
+	free(_archive->_identifiers);
+	free(_archive->_positions);
+	for(_channel=0;_channel<LHC_CHANNELS;_channel++) free(_archive->_channels[_channel]);
+	free(_archive);
+}
+
+/** Function to allocate the columns of 'n' measures. Returns 0, or -1 if there is no memory. */
+static int allocate_Archive(LHC_Archive *_archive, size_t n) {
+
+	unsigned int _channel;
+	int _error = 0;
+
+	/** At least one measure, so an empty file is not mistaken for a failure */
+	_archive->_number_Of_Measures = n;
+	if(n==0) n = 1;
+	_archive->_turns = ( unsigned int* ) malloc( n*sizeof( unsigned int ) );
+	_archive->_identifiers = ( int* ) malloc( n*sizeof( int ) );
+	_archive->_positions = ( float* ) malloc( n*sizeof( float ) );
+	_error |= !_archive->_turns || !_archive->_identifiers || !_archive->_positions;
+	for(_channel=0;_channel<LHC_CHANNELS;_channel++) {
+		_archive->_channels[_channel] = ( float* ) malloc( n*sizeof( float ) );
+		_error |= !_archive->_channels[_channel];
+	}
+	return _error ? -1 : 0;
+}
+
+LHC_Archive* load_Archive(const char *_name, unsigned int _threads, size_t *_bad_Line) {
+
+	LHC_Archive*	_archive = NULL;
+	Archive_Job		_job;
+	Archive_Chunk*	_chunks = NULL;
+	struct stat		_stat;
+	const char*		_map = NULL;
+	size_t			_size = 0, _lines = 0;
+	unsigned int	n, i;
+	int				_fd, _error = 0;
+
+	if(_bad_Line) *_bad_Line = 0;
+	if(_threads==0) _threads = (unsigned int)sysconf(_SC_NPROCESSORS_ONLN);
+	if(_threads==0) _threads = 1;
+
+	_fd = open(_name, O_RDONLY);
+	if(_fd<0) return NULL;
+	if(fstat(_fd, &_stat)!=0) _error = errno;
+	else if((_size = (size_t)_stat.st_size) > 0) {
+		_map = ( const char* ) mmap(NULL, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+		if(_map==MAP_FAILED) {
+			_error = errno;
+			_map = NULL;
+		}
+		else madvise((void*)_map, _size, MADV_SEQUENTIAL | MADV_WILLNEED);
+	}
+	close(_fd);
+	if(_error!=0) {
+		errno = _error;
+		return NULL;
+	}
+
+	/** Chunks of about the same size, every one moved to the start of a line */
+	n = (unsigned int)(_size/ARCHIVE_MIN_CHUNK);
+	if(n > _threads*ARCHIVE_CHUNKS) n = _threads*ARCHIVE_CHUNKS;
+	if(n==0) n = 1;
+	if(_threads > n) _threads = n;
+	_archive = ( LHC_Archive* ) calloc( 1, sizeof( LHC_Archive ) );
+	_chunks = ( Archive_Chunk* ) calloc( n, sizeof( Archive_Chunk ) );
+	if(!_archive || !_chunks) _error = ENOMEM;
+	else {
+		for(i=0;i<n;i++) {
+			const char* _begin = _map + _size/n*i;
+			const char* _line;
+
+			/** A long line may have moved the chunk before past this one */
+			if(i>0 && _begin < _chunks[i-1]._begin) _begin = _chunks[i-1]._begin;
+			if(i>0 && (_line = ( const char* ) memchr(_begin-1, '\n', _map+_size-(_begin-1)))) _begin = _line+1;
+			else if(i>0) _begin = _map+_size;
+			_chunks[i]._begin = _begin;
+			if(i>0) _chunks[i-1]._end = _begin;
+		}
+		_chunks[n-1]._end = _map+_size;
+
+		/** Lines of every chunk, so every one knows where its measures go */
+		_job._archive = _archive;
+		_job._chunks = _chunks;
+		_job._number_Of_Chunks = n;
+		_job._parse = 0;
+		run_Archive_Job(&_job, _threads);
+		for(i=0;i<n;i++) {
+			_chunks[i]._first = _lines;
+			_lines += _chunks[i]._lines;
+		}
+
+		if(allocate_Archive(_archive, _lines)!=0) _error = ENOMEM;
+		else {
+			_job._parse = 1;
+			run_Archive_Job(&_job, _threads);
+			for(i=0;i<n && _error==0;i++) {
+				if(_chunks[i]._bad_Line) {
+					if(_bad_Line) *_bad_Line = _chunks[i]._first + _chunks[i]._bad_Line;
+					_error = EILSEQ;
+				}
+			}
+		}
+	}
+
+	if(_map) munmap((void*)_map, _size);
+	free(_chunks);
+	if(_error!=0) {
+		destroy_Archive(_archive);
+		errno = _error;
+		return NULL;
+	}
+	return _archive;
+}
@@ -0,0 +1,259 @@
+//==============================================================================//
+//  Filename: lhc_correlation.c													//
+//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+/* Local includes */
+#include "../include/lhc_correlation.h"
+
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CORRELATION_BLOCK 64			/* Series per block: a block pair is computed at once. */
+#define CORRELATION_CHUNK 256			/* Turns per chunk: the rows of a block pair stay in cache. */
+
+/** Four floats processed at once (SSE / NEON, or whatever the compiler targets) */
+typedef float v4f __attribute__((vector_size(16)));
+
+static inline v4f load_V4(const float *_p) {
+	v4f _v;
+	memcpy(&_v, _p, sizeof(_v));
+	return _v;
+}
+
+static inline float sum_V4(v4f _v) {
+	return (_v[0]+_v[1]) + (_v[2]+_v[3]);
+}
+
+/** Work shared by the threads: every item is one lag and one block pair */
+typedef struct _Correlation_Job{
+	const float*		_centered;		/** Series minus their mean */
+	LHC_Correlation*	_correlation;
+	unsigned int		_number_Of_Blocks;
+	unsigned long		_number_Of_Items;
+	unsigned long		_next;
+} Correlation_Job;
+
+/** Function to accumulate sum(a[t]*b[t]) for t in [0,n) of one pair */
+static float dot_1x1(const float *_a, const float *_b, unsigned int n) {
+
+	v4f 		_acc = {0, 0, 0, 0};
+	float		_sum;
+	unsigned int t;
+
+	for(t=0;t+4<=n;t+=4) _acc += load_V4(_a+t)*load_V4(_b+t);
+	_sum = sum_V4(_acc);
+	for(;t<n;t++) _sum += _a[t]*_b[t];
+
+	return _sum;
+}
+
+/** Function to accumulate the 2x4 pairs of two 'a' rows and four 'b' rows at once: every
+ *  value loaded is used 2 or 4 times */
+static void dot_2x4(const float *_a[2], const float *_b[4], unsigned int n, float _sum[2][4]) {
+
+	v4f 		_acc[2][4];
+	unsigned int t, j, k;
+
+	memset(_acc, 0, sizeof(_acc));
+	for(t=0;t+4<=n;t+=4) {
+		v4f _va0 = load_V4(_a[0]+t), _va1 = load_V4(_a[1]+t);
+
+		for(k=0;k<4;k++) {
+			v4f _vb = load_V4(_b[k]+t);
+			_acc[0][k] += _va0*_vb;
+			_acc[1][k] += _va1*_vb;
+		}
+	}
+	for(j=0;j<2;j++) for(k=0;k<4;k++) {
+		_sum[j][k] = sum_V4(_acc[j][k]);
+		for(t=n&~3u;t<n;t++) _sum[j][k] += _a[j][t]*_b[k][t];
+	}
+}
+
+/** Function to compute the covariance of one block pair at one lag. Turns go in chunks, so
+ *  the rows of both blocks are reused from cache; every chunk is added in double. */
+static void correlate_Block(const Correlation_Job *_job, unsigned int _lag, unsigned int _block_A, unsigned int _block_B) {
+
+	LHC_Correlation* _correlation = _job->_correlation;
+	unsigned int	_turns = _correlation->_number_Of_Turns, _series = _correlation->_number_Of_Series;
+	unsigned int	_a0 = _block_A*CORRELATION_BLOCK, _b0 = _block_B*CORRELATION_BLOCK;
+	unsigned int	_a1 = _a0+CORRELATION_BLOCK < _series ? _a0+CORRELATION_BLOCK : _series;
+	unsigned int	_b1 = _b0+CORRELATION_BLOCK < _series ? _b0+CORRELATION_BLOCK : _series;
+	unsigned int	n = _turns - _lag, _start, _length, a, b, j, k;
+	double			_acc[CORRELATION_BLOCK][CORRELATION_BLOCK];
+
+	memset(_acc, 0, sizeof(_acc));
+	for(_start=0;_start<n;_start+=CORRELATION_CHUNK) {
+		_length = (n-_start < CORRELATION_CHUNK) ? n-_start : CORRELATION_CHUNK;
+
+		for(a=_a0;a<_a1;a+=2) {
+			for(b=_b0;b<_b1;b+=4) {
+				if(a+2<=_a1 && b+4<=_b1) {
+					const float* _rows_A[2];
+					const float* _rows_B[4];
+					float _sum[2][4];
+
+					for(j=0;j<2;j++) _rows_A[j] = _job->_centered + (size_t)(a+j)*_turns + _start;
+					for(k=0;k<4;k++) _rows_B[k] = _job->_centered + (size_t)(b+k)*_turns + _lag + _start;
+					dot_2x4(_rows_A, _rows_B, _length, _sum);
+					for(j=0;j<2;j++) for(k=0;k<4;k++) _acc[a+j-_a0][b+k-_b0] += _sum[j][k];
+				} else {
+					/** Edges of the matrix */
+					for(j=a;j<a+2 && j<_a1;j++) for(k=b;k<b+4 && k<_b1;k++)
+						_acc[j-_a0][k-_b0] += dot_1x1(_job->_centered + (size_t)j*_turns + _start,
+								_job->_centered + (size_t)k*_turns + _lag + _start, _length);
+				}
+			}
+		}
+	}
+
+	for(a=_a0;a<_a1;a++) for(b=_b0;b<_b1;b++) {
+		float _covariance = (float)(_acc[a-_a0][b-_b0]/n);
+		float _deviation = _correlation->_deviation[a]*_correlation->_deviation[b];
+
+		CORRELATION_AT(_correlation->_covariance, _correlation, _lag, a, b) = _covariance;
+		CORRELATION_AT(_correlation->_correlation, _correlation, _lag, a, b) = _deviation>0 ? _covariance/_deviation : 0;
+	}
+}
+
+/** Thread: takes items (lag, block pair) until there is none left */
+static void* correlation_Worker(void *_arg) {
+
+	Correlation_Job* _job = ( Correlation_Job* ) _arg;
+	unsigned long	_item, _pairs = (unsigned long)_job->_number_Of_Blocks*_job->_number_Of_Blocks;
+
+	while((_item = __atomic_fetch_add(&_job->_next, 1, __ATOMIC_RELAXED)) < _job->_number_Of_Items) {
+		unsigned long _pair = _item % _pairs;
+
+		correlate_Block(_job, _item / _pairs, _pair / _job->_number_Of_Blocks, _pair % _job->_number_Of_Blocks);
+	}
+	return NULL;
+}
+
+void destroy_Correlation(LHC_Correlation *_correlation) {
+
+	if(!_correlation) return;
+	free(_correlation->_mean);
+	free(_correlation->_deviation);
+	free(_correlation->_covariance);
+	free(_correlation->_correlation);
+	free(_correlation);
+}
+
+/** Function to correlate all the series of a run, lags 0.._max_Lag */
+LHC_Correlation* correlate_Series(const LHC_Series *_series, unsigned int _max_Lag, unsigned int _number_Of_Threads) {
+
+	LHC_Correlation* _correlation;
+	Correlation_Job	_job;
+	pthread_t*		_threads;
+	float*			_centered;
+	unsigned int	_rows, _turns, s, t, i, _created=0;
+	size_t			_matrices;
+
+	if(!_series || _series->_number_Of_Turns==0 || _max_Lag >= _series->_number_Of_Turns) {
+		errno = EINVAL;
+		return NULL;
+	}
+	_rows = _series->_number_Of_Nodes*LHC_CHANNELS;
+	_turns = _series->_number_Of_Turns;
+	if(_number_Of_Threads==0) _number_Of_Threads = (unsigned int)sysconf(_SC_NPROCESSORS_ONLN);
+	if(_number_Of_Threads==0) _number_Of_Threads = 1;
+
+	_correlation = ( LHC_Correlation* ) calloc( 1, sizeof( LHC_Correlation ) );
+	if(!_correlation) return NULL;
+	_correlation->_number_Of_Series = _rows;
+	_correlation->_number_Of_Lags = _max_Lag+1;
+	_correlation->_number_Of_Turns = _turns;
+	_matrices = (size_t)_correlation->_number_Of_Lags*_rows*_rows;
+	_correlation->_mean = ( float* ) calloc( _rows, sizeof( float ) );
+	_correlation->_deviation = ( float* ) calloc( _rows, sizeof( float ) );
+	_correlation->_covariance = ( float* ) malloc( _matrices*sizeof( float ) );
+	_correlation->_correlation = ( float* ) malloc( _matrices*sizeof( float ) );
+	_centered = ( float* ) malloc( (size_t)_rows*_turns*sizeof( float ) );
+	_threads = ( pthread_t* ) calloc( _number_Of_Threads, sizeof( pthread_t ) );
+	if(!_correlation->_mean || !_correlation->_deviation || !_correlation->_covariance ||
+			!_correlation->_correlation || !_centered || !_threads) {
+		free(_threads);
+		free(_centered);
+		destroy_Correlation(_correlation);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	/** Mean and deviation of every series (in double), and the centered copy the kernels use */
+	for(s=0;s<_rows;s++) {
+		const float* _row = _series->_data + (size_t)s*_turns;
+		float* _out = _centered + (size_t)s*_turns;
+		double _sum=0, _squares=0;
+
+		for(t=0;t<_turns;t++) _sum += _row[t];
+		_correlation->_mean[s] = (float)(_sum/_turns);
+		for(t=0;t<_turns;t++) {
+			_out[t] = _row[t] - _correlation->_mean[s];
+			_squares += (double)_out[t]*_out[t];
+		}
+		_correlation->_deviation[s] = (float)sqrt(_squares/_turns);
+	}
+
+	/** All lags and block pairs are shared between the threads */
+	_job._centered = _centered;
+	_job._correlation = _correlation;
+	_job._number_Of_Blocks = (_rows + CORRELATION_BLOCK-1)/CORRELATION_BLOCK;
+	_job._number_Of_Items = (unsigned long)_correlation->_number_Of_Lags*_job._number_Of_Blocks*_job._number_Of_Blocks;
+	_job._next = 0;
+	if(_number_Of_Threads > _job._number_Of_Items) _number_Of_Threads = _job._number_Of_Items;
+
+	for(i=1;i<_number_Of_Threads;i++) {
+		if(pthread_create(&_threads[i], NULL, correlation_Worker, &_job)!=0) break;
+		_created++;
+	}
+	correlation_Worker(&_job);
+	for(i=1;i<=_created;i++) pthread_join(_threads[i], NULL);
+
+	free(_threads);
+	free(_centered);
+
+	return _correlation;
+}
+
+/** Function to write the matrices in the binary format (see LHC_CORRELATION_MAGIC) */
+int write_Correlation(const LHC_Correlation *_correlation, const LHC_Series *_series, const char *_name) {
+
+	FILE*		fp;
+	uint32_t	_header[3], _label[2];
+	size_t		_matrix = (size_t)_correlation->_number_Of_Series*_correlation->_number_Of_Series;
+	unsigned int s, _lag;
+	int			_error=0;
+
+	fp = fopen(_name, "wb");
+	if(!fp) return errno;
+
+	_header[0] = _correlation->_number_Of_Series;
+	_header[1] = _correlation->_number_Of_Lags;
+	_header[2] = _correlation->_number_Of_Turns;
+	fwrite(LHC_CORRELATION_MAGIC, 1, 8, fp);
+	fwrite(_header, sizeof(uint32_t), 3, fp);
+	for(s=0;s<_correlation->_number_Of_Series;s++) {
+		_label[0] = (uint32_t)_series->_identifiers[s/LHC_CHANNELS];
+		_label[1] = s%LHC_CHANNELS;
+		fwrite(_label, sizeof(uint32_t), 2, fp);
+	}
+	for(_lag=0;_lag<_correlation->_number_Of_Lags;_lag++) {
+		fwrite(_correlation->_covariance + _lag*_matrix, sizeof(float), _matrix, fp);
+		fwrite(_correlation->_correlation + _lag*_matrix, sizeof(float), _matrix, fp);
+	}
+
+	if(ferror(fp)) _error = EIO;
+	if(fclose(fp)!=0 && _error==0) _error = errno;
+
+	return _error;
+}
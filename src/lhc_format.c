@@ -0,0 +1,136 @@
+//==============================================================================//
+//  Filename: lhc_format.c														//
+//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+/* Local includes */
+#include "../include/lhc_simulator.h"
+#include "../include/lhc_format.h"
+
+#define FORMAT_SCALE 1000000ULL			/* 6 decimals, as "%f". */
+#define FORMAT_FAST_EXP 32				/* Floats below 2^32 take the fast path. */
+
+/** Pairs of digits "00".."99": two digits per division */
+static const char _digits[201] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+/** Function to write an unsigned integer in decimal. Returns the amount of bytes written. */
+static size_t format_Unsigned(char *_out, uint64_t _value) {
+
+	char 	_tmp[20];
+	char* 	_p = _tmp + sizeof(_tmp);
+	size_t	_length;
+
+	while(_value>=100) {
+		unsigned int _pair = (unsigned int)(_value % 100)*2;
+		_value /= 100;
+		*--_p = _digits[_pair+1];
+		*--_p = _digits[_pair];
+	}
+	if(_value>=10) {
+		*--_p = _digits[_value*2+1];
+		*--_p = _digits[_value*2];
+	} else *--_p = (char)('0'+_value);
+
+	_length = _tmp + sizeof(_tmp) - _p;
+	memcpy(_out, _p, _length);
+
+	return _length;
+}
+
+size_t format_Int(char *_out, int _value) {
+
+	if(_value<0) {
+		*_out = '-';
+		return 1 + format_Unsigned(_out+1, -(int64_t)_value);
+	}
+	return format_Unsigned(_out, _value);
+}
+
+/** Function to write a float as "%f". A float below 2^32 is m*2^e with m < 2^24, so
+ *  value*10^6 = m*10^6*2^e is computed exactly in 64 bits and rounded to an integer
+ *  (ties to even, as printf does on the exact binary value). */
+size_t format_Float(char *_out, float _value) {
+
+	uint32_t	_bits;
+	uint64_t	_mantissa, _scaled;
+	int			_exponent;
+	size_t		_length=0;
+
+	memcpy(&_bits, &_value, sizeof(_bits));
+	_exponent = (_bits>>23) & 0xff;
+	_mantissa = _bits & 0x7fffff;
+
+	/** Huge, infinite or NaN values are rare enough to be left to printf */
+	if(_exponent-127 >= FORMAT_FAST_EXP) return sprintf(_out, "%f", _value);
+
+	if(_exponent==0) _exponent = -149;						/** Subnormal */
+	else {
+		_mantissa |= 0x800000;
+		_exponent -= 150;
+	}
+	if(_bits>>31) _out[_length++] = '-';
+
+	_scaled = _mantissa*FORMAT_SCALE;
+	if(_exponent>=0) _scaled <<= _exponent;
+	else if(-_exponent >= 64 || (_scaled >> (-_exponent-1))==0) _scaled = 0;	/** Below half a unit */
+	else {
+		uint64_t _half = 1ULL << (-_exponent-1);
+		uint64_t _rest = _scaled & ((_half<<1)-1);
+
+		_scaled >>= -_exponent;
+		if(_rest>_half || (_rest==_half && (_scaled & 1))) _scaled++;
+	}
+
+	/** Integer part, point and the 6 decimals (with their leading zeros) */
+	_length += format_Unsigned(_out+_length, _scaled / FORMAT_SCALE);
+	_out[_length++] = '.';
+	{
+		unsigned int _decimals = (unsigned int)(_scaled % FORMAT_SCALE), _pair;
+		char* _p = _out + _length + 6;
+
+		for(_pair=0;_pair<3;_pair++) {
+			unsigned int _two = (_decimals % 100)*2;
+			_decimals /= 100;
+			*--_p = _digits[_two+1];
+			*--_p = _digits[_two];
+		}
+	}
+
+	return _length + 6;
+}
+
+/** Function to write "i:id;pos;rad;speed;current;temp;pressure;phase.\n" */
+size_t format_Measure_Line(char *_out, unsigned int i, const Measure *_measure) {
+
+	size_t _length;
+
+	_length  = format_Int(_out, (int)i);
+	_out[_length++] = ':';
+	_length += format_Int(_out+_length, _measure->_identifier);
+	_out[_length++] = ';';
+	_length += format_Float(_out+_length, _measure->_position);
+	_out[_length++] = ';';
+	_length += format_Float(_out+_length, _measure->_particle_Radiation);
+	_out[_length++] = ';';
+	_length += format_Float(_out+_length, _measure->_particle_Speed);
+	_out[_length++] = ';';
+	_length += format_Float(_out+_length, _measure->_magnet_Current);
+	_out[_length++] = ';';
+	_length += format_Float(_out+_length, _measure->_helium_Temp);
+	_out[_length++] = ';';
+	_length += format_Float(_out+_length, _measure->_helium_Pressure);
+	_out[_length++] = ';';
+	_length += format_Float(_out+_length, _measure->_phase_RF);
+	_out[_length++] = '.';
+	_out[_length++] = '\n';
+
+	return _length;
+}
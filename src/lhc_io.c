@@ -0,0 +1,494 @@
+//==============================================================================//
+//  Filename: lhc_io.c															//
+//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+/* Local includes */
+#include "../include/lhc_io.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define LHC_HAVE_IO_URING 1
+#endif
+
+#define IO_RING_ENTRIES 64				/* Entries of the submission queue. */
+#define IO_MAX_REGISTERED 1024			/* Buffers the kernel accepts in one registration. */
+
+
+/*  IO_URING  */
+/*~~~~~~~~~~~~*/
+#ifdef LHC_HAVE_IO_URING
+
+/* The ring is driven with the raw system calls, so no extra library is needed. Only the
+ engine thread touches it: it is the single producer of submissions and the single consumer
+ of completions. */
+typedef struct _IO_Ring{
+	int _fd;
+	unsigned int _entries;
+
+	/** Submission queue */
+	unsigned int *_sq_Head, *_sq_Tail, *_sq_Mask, *_sq_Array;
+	struct io_uring_sqe* _sqes;
+
+	/** Completion queue */
+	unsigned int *_cq_Head, *_cq_Tail, *_cq_Mask;
+	struct io_uring_cqe* _cqes;
+
+	/** Mappings */
+	void *_sq_Ptr, *_cq_Ptr;
+	size_t _sq_Size, _cq_Size, _sqes_Size;
+
+	/** Buffers registered (WRITE_FIXED) or not (WRITEV with one iovec per buffer). */
+	int _fixed;
+	struct iovec* _iovecs;
+
+	/** Entries written to the submission queue and not consumed by the kernel yet, and
+	 *  entries consumed whose completion has not arrived. */
+	unsigned int _unsubmitted;
+	unsigned int _inflight;
+
+	/** Set when io_uring_enter failed: the ring is drained and dropped. */
+	int _broken;
+} IO_Ring;
+
+static void destroy_Ring(IO_Ring *_ring) {
+
+	if(_ring->_sqes) munmap(_ring->_sqes, _ring->_sqes_Size);
+	if(_ring->_cq_Ptr && _ring->_cq_Ptr!=_ring->_sq_Ptr) munmap(_ring->_cq_Ptr, _ring->_cq_Size);
+	if(_ring->_sq_Ptr) munmap(_ring->_sq_Ptr, _ring->_sq_Size);
+	if(_ring->_fd>=0) close(_ring->_fd);
+	free(_ring->_iovecs);
+	free(_ring);
+}
+
+/** Function to set up the ring and register the pool of buffers. NULL if io_uring is not
+ *  available (old kernel, seccomp, ...). */
+static IO_Ring* create_Ring(LHC_IO_Engine *_engine) {
+
+	struct io_uring_params _params;
+	IO_Ring* _ring;
+	unsigned int i;
+
+	_ring = ( IO_Ring* ) calloc( 1, sizeof( IO_Ring ) );
+	if(!_ring) return NULL;
+	_ring->_iovecs = ( struct iovec* ) calloc( _engine->_number_Of_Buffers, sizeof( struct iovec ) );
+	memset(&_params, 0, sizeof(_params));
+	_ring->_fd = syscall(__NR_io_uring_setup, IO_RING_ENTRIES, &_params);
+	if(_ring->_fd<0 || !_ring->_iovecs) {
+		destroy_Ring(_ring);
+		return NULL;
+	}
+	_ring->_entries = _params.sq_entries;
+
+	_ring->_sq_Size = _params.sq_off.array + _params.sq_entries*sizeof(unsigned int);
+	_ring->_cq_Size = _params.cq_off.cqes + _params.cq_entries*sizeof(struct io_uring_cqe);
+	if(_params.features & IORING_FEAT_SINGLE_MMAP) {
+		if(_ring->_cq_Size > _ring->_sq_Size) _ring->_sq_Size = _ring->_cq_Size;
+		_ring->_cq_Size = _ring->_sq_Size;
+	}
+	_ring->_sq_Ptr = mmap(NULL, _ring->_sq_Size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+			_ring->_fd, IORING_OFF_SQ_RING);
+	if(_ring->_sq_Ptr==MAP_FAILED) {
+		_ring->_sq_Ptr = NULL;
+		destroy_Ring(_ring);
+		return NULL;
+	}
+	if(_params.features & IORING_FEAT_SINGLE_MMAP) _ring->_cq_Ptr = _ring->_sq_Ptr;
+	else {
+		_ring->_cq_Ptr = mmap(NULL, _ring->_cq_Size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+				_ring->_fd, IORING_OFF_CQ_RING);
+		if(_ring->_cq_Ptr==MAP_FAILED) {
+			_ring->_cq_Ptr = NULL;
+			destroy_Ring(_ring);
+			return NULL;
+		}
+	}
+	_ring->_sqes_Size = _params.sq_entries*sizeof(struct io_uring_sqe);
+	_ring->_sqes = mmap(NULL, _ring->_sqes_Size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+			_ring->_fd, IORING_OFF_SQES);
+	if(_ring->_sqes==MAP_FAILED) {
+		_ring->_sqes = NULL;
+		destroy_Ring(_ring);
+		return NULL;
+	}
+
+	_ring->_sq_Head = (unsigned int*)((char*)_ring->_sq_Ptr + _params.sq_off.head);
+	_ring->_sq_Tail = (unsigned int*)((char*)_ring->_sq_Ptr + _params.sq_off.tail);
+	_ring->_sq_Mask = (unsigned int*)((char*)_ring->_sq_Ptr + _params.sq_off.ring_mask);
+	_ring->_sq_Array = (unsigned int*)((char*)_ring->_sq_Ptr + _params.sq_off.array);
+	_ring->_cq_Head = (unsigned int*)((char*)_ring->_cq_Ptr + _params.cq_off.head);
+	_ring->_cq_Tail = (unsigned int*)((char*)_ring->_cq_Ptr + _params.cq_off.tail);
+	_ring->_cq_Mask = (unsigned int*)((char*)_ring->_cq_Ptr + _params.cq_off.ring_mask);
+	_ring->_cqes = (struct io_uring_cqe*)((char*)_ring->_cq_Ptr + _params.cq_off.cqes);
+
+	/** Registered buffers save the kernel from mapping the pages on every write. If the
+	 *  registration is refused (RLIMIT_MEMLOCK...) plain vectored writes are used. */
+	for(i=0;i<_engine->_number_Of_Buffers;i++) {
+		_ring->_iovecs[i].iov_base = _engine->_buffers[i]._data;
+		_ring->_iovecs[i].iov_len = _engine->_buffers[i]._size;
+	}
+	if(_engine->_number_Of_Buffers<=IO_MAX_REGISTERED &&
+			syscall(__NR_io_uring_register, _ring->_fd, IORING_REGISTER_BUFFERS,
+					_ring->_iovecs, _engine->_number_Of_Buffers)==0)
+		_ring->_fixed = 1;
+
+	return _ring;
+}
+
+/** Function to queue the (remaining part of the) write of a buffer */
+static void prepare_Write(IO_Ring *_ring, LHC_IO_Buffer *_buffer) {
+
+	unsigned int _tail = *_ring->_sq_Tail, _index = _tail & *_ring->_sq_Mask;
+	struct io_uring_sqe* _sqe = &_ring->_sqes[_index];
+
+	memset(_sqe, 0, sizeof(struct io_uring_sqe));
+	_sqe->fd = _buffer->_file->_fd;
+	_sqe->off = _buffer->_offset + _buffer->_done;
+	_sqe->user_data = (uint64_t)(uintptr_t)_buffer;
+	if(_ring->_fixed) {
+		_sqe->opcode = IORING_OP_WRITE_FIXED;
+		_sqe->addr = (uint64_t)(uintptr_t)(_buffer->_data + _buffer->_done);
+		_sqe->len = _buffer->_length - _buffer->_done;
+		_sqe->buf_index = _buffer->_index;
+	} else {
+		_ring->_iovecs[_buffer->_index].iov_base = _buffer->_data + _buffer->_done;
+		_ring->_iovecs[_buffer->_index].iov_len = _buffer->_length - _buffer->_done;
+		_sqe->opcode = IORING_OP_WRITEV;
+		_sqe->addr = (uint64_t)(uintptr_t)&_ring->_iovecs[_buffer->_index];
+		_sqe->len = 1;
+	}
+	_ring->_sq_Array[_index] = _index;
+	__atomic_store_n(_ring->_sq_Tail, _tail+1, __ATOMIC_RELEASE);
+
+	_ring->_unsubmitted++;
+	_ring->_inflight++;
+}
+
+/** Function to submit the queued writes and, if requested, wait for one completion */
+static int enter_Ring(IO_Ring *_ring, int _wait) {
+
+	int _ret;
+
+	do {
+		_ret = syscall(__NR_io_uring_enter, _ring->_fd, _ring->_unsubmitted, _wait ? 1 : 0,
+				_wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+	} while(_ret<0 && errno==EINTR);
+	if(_ret>0) _ring->_unsubmitted -= _ret;
+
+	return _ret<0 ? errno : 0;
+}
+
+#endif /* LHC_HAVE_IO_URING */
+
+
+/*  ENGINE FUNCTIONS  */
+/*~~~~~~~~~~~~~~~~~~~~*/
+/** Function to give a buffer back to the pool once written. Call it with the MUTEX on. */
+static void complete_Buffer(LHC_IO_Engine *_engine, LHC_IO_Buffer *_buffer, int _error) {
+
+	LHC_IO_File* _file = _buffer->_file;
+
+	if(_error!=0 && _file->_error==0) _file->_error = _error;
+	_file->_pending--;
+
+	_buffer->_file = NULL;
+	_buffer->_next = _engine->_free;
+	_engine->_free = _buffer;
+	pthread_cond_broadcast(&_engine->_done);
+}
+
+/** Function to take the first buffer of the queue. Call it with the MUTEX on. */
+static LHC_IO_Buffer* pop_Queue(LHC_IO_Engine *_engine) {
+
+	LHC_IO_Buffer* _buffer = _engine->_queue_Head;
+
+	_engine->_queue_Head = _buffer->_next;
+	if(!_engine->_queue_Head) _engine->_queue_Tail = NULL;
+	_buffer->_next = NULL;
+
+	return _buffer;
+}
+
+/** Function to write a whole buffer with blocking calls (fallback). Returns 0 or an errno. */
+static int write_Blocking(LHC_IO_Buffer *_buffer) {
+
+	ssize_t _written;
+
+	while(_buffer->_done < _buffer->_length) {
+		_written = pwrite(_buffer->_file->_fd, _buffer->_data + _buffer->_done,
+				_buffer->_length - _buffer->_done, _buffer->_offset + _buffer->_done);
+		if(_written<0 && errno==EINTR) continue;
+		if(_written<=0) return _written<0 ? errno : EIO;
+		_buffer->_done += _written;
+	}
+	return 0;
+}
+
+/** Thread of the engine: it is the only one writing to disk. */
+static void* io_Engine_Thread(void *_arg) {
+
+	LHC_IO_Engine* _engine = ( LHC_IO_Engine* ) _arg;
+	LHC_IO_Buffer* _buffer;
+
+	pthread_mutex_lock(&_engine->_mutex);
+	for(;;) {
+#ifdef LHC_HAVE_IO_URING
+		IO_Ring* _ring = ( IO_Ring* ) _engine->_ring;
+
+		if(_ring) {
+			unsigned int _head, _tail;
+			int _error;
+
+			while((!_engine->_queue_Head || _ring->_broken) && _ring->_inflight==0 && !_engine->_stop)
+				pthread_cond_wait(&_engine->_work, &_engine->_mutex);
+			if(!_engine->_queue_Head && _ring->_inflight==0) break;
+
+			/** Every buffer waiting in the queue goes to the ring in one batch... */
+			while(_engine->_queue_Head && _ring->_inflight < _ring->_entries && !_ring->_broken)
+				prepare_Write(_ring, pop_Queue(_engine));
+			pthread_mutex_unlock(&_engine->_mutex);
+
+			/** ...and we only wait in the kernel when there was nothing new to submit. */
+			_error = enter_Ring(_ring, _ring->_unsubmitted==0);
+
+			pthread_mutex_lock(&_engine->_mutex);
+			if(_error!=0 && _error!=EAGAIN && _error!=EBUSY) {
+				/** The ring is broken: the writes the kernel did not take go back to the
+				 *  queue, and once the ones it took are completed the rest of the buffers
+				 *  are written with the fallback. */
+				unsigned int _sq_Tail = *_ring->_sq_Tail;
+
+				if(!_ring->_broken) fprintf(stderr, "io_uring failed (%s), falling back to blocking writes.\n", strerror(_error));
+				_ring->_broken = 1;
+				while(_ring->_unsubmitted>0) {
+					_sq_Tail--;
+					_buffer = (LHC_IO_Buffer*)(uintptr_t)_ring->_sqes[_sq_Tail & *_ring->_sq_Mask].user_data;
+					_buffer->_next = _engine->_queue_Head;
+					_engine->_queue_Head = _buffer;
+					if(!_engine->_queue_Tail) _engine->_queue_Tail = _buffer;
+					_ring->_unsubmitted--;
+					_ring->_inflight--;
+				}
+				__atomic_store_n(_ring->_sq_Tail, _sq_Tail, __ATOMIC_RELEASE);
+			}
+
+			/** Reap all the completions available */
+			_head = *_ring->_cq_Head;
+			_tail = __atomic_load_n(_ring->_cq_Tail, __ATOMIC_ACQUIRE);
+			for(;_head!=_tail;_head++) {
+				struct io_uring_cqe* _cqe = &_ring->_cqes[_head & *_ring->_cq_Mask];
+
+				_buffer = (LHC_IO_Buffer*)(uintptr_t)_cqe->user_data;
+				_ring->_inflight--;
+				if(_cqe->res<0) 		complete_Buffer(_engine, _buffer, -_cqe->res);
+				else if(_cqe->res==0) 	complete_Buffer(_engine, _buffer, EIO);
+				else {
+					_buffer->_done += _cqe->res;
+					if(_buffer->_done >= _buffer->_length) complete_Buffer(_engine, _buffer, 0);
+					else {
+						/** Short write: the rest goes back to the head of the queue */
+						_buffer->_next = _engine->_queue_Head;
+						_engine->_queue_Head = _buffer;
+						if(!_engine->_queue_Tail) _engine->_queue_Tail = _buffer;
+					}
+				}
+			}
+			__atomic_store_n(_ring->_cq_Head, _head, __ATOMIC_RELEASE);
+
+			if(_ring->_broken && _ring->_inflight==0) {
+				destroy_Ring(_ring);
+				_engine->_ring = NULL;
+			}
+			continue;
+		}
+#endif
+		/** Blocking fallback: one buffer at a time */
+		while(!_engine->_queue_Head && !_engine->_stop)
+			pthread_cond_wait(&_engine->_work, &_engine->_mutex);
+		if(!_engine->_queue_Head) break;
+
+		_buffer = pop_Queue(_engine);
+		pthread_mutex_unlock(&_engine->_mutex);
+		{
+			int _error = write_Blocking(_buffer);
+			pthread_mutex_lock(&_engine->_mutex);
+			complete_Buffer(_engine, _buffer, _error);
+		}
+	}
+	pthread_mutex_unlock(&_engine->_mutex);
+
+	return NULL;
+}
+
+/** Function to create an engine with a pool of '_number_Of_Buffers' buffers of '_size' bytes */
+LHC_IO_Engine* create_IO_Engine(unsigned int _number_Of_Buffers, size_t _size, int _use_Uring) {
+
+	LHC_IO_Engine* _engine;
+	unsigned int i;
+
+	if(_number_Of_Buffers==0 || _size==0) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	_engine = ( LHC_IO_Engine* ) calloc( 1, sizeof( LHC_IO_Engine ) );
+	if(!_engine) return NULL;
+	_engine->_number_Of_Buffers = _number_Of_Buffers;
+	_engine->_buffers = ( LHC_IO_Buffer* ) calloc( _number_Of_Buffers, sizeof( LHC_IO_Buffer ) );
+
+	/** All the buffers come from one page-aligned block */
+	_size = (_size + 4095) & ~(size_t)4095;
+	if(!_engine->_buffers || posix_memalign((void**)&_engine->_memory, 4096, _size*_number_Of_Buffers)!=0) {
+		free(_engine->_buffers);
+		free(_engine);
+		errno = ENOMEM;
+		return NULL;
+	}
+	for(i=0;i<_number_Of_Buffers;i++) {
+		_engine->_buffers[i]._data = _engine->_memory + i*_size;
+		_engine->_buffers[i]._size = _size;
+		_engine->_buffers[i]._index = i;
+		_engine->_buffers[i]._next = (i+1<_number_Of_Buffers) ? &_engine->_buffers[i+1] : NULL;
+	}
+	_engine->_free = &_engine->_buffers[0];
+
+#ifdef LHC_HAVE_IO_URING
+	if(_use_Uring) _engine->_ring = create_Ring(_engine);
+#else
+	(void)_use_Uring;
+#endif
+
+	pthread_mutex_init(&_engine->_mutex, NULL);
+	pthread_cond_init(&_engine->_work, NULL);
+	pthread_cond_init(&_engine->_done, NULL);
+	if((errno = pthread_create(&_engine->_thread, NULL, io_Engine_Thread, _engine))!=0) {
+		int _error = errno;
+
+#ifdef LHC_HAVE_IO_URING
+		if(_engine->_ring) destroy_Ring(( IO_Ring* ) _engine->_ring);
+#endif
+		pthread_cond_destroy(&_engine->_done);
+		pthread_cond_destroy(&_engine->_work);
+		pthread_mutex_destroy(&_engine->_mutex);
+		free(_engine->_memory);
+		free(_engine->_buffers);
+		free(_engine);
+		errno = _error;
+		return NULL;
+	}
+
+	return _engine;
+}
+
+/** Function to stop the engine once everything handed to it is written, and free it */
+void destroy_IO_Engine(LHC_IO_Engine *_engine) {
+
+	if(!_engine) return;
+
+	pthread_mutex_lock(&_engine->_mutex);
+	_engine->_stop = 1;
+	pthread_cond_signal(&_engine->_work);
+	pthread_mutex_unlock(&_engine->_mutex);
+	pthread_join(_engine->_thread, NULL);
+
+#ifdef LHC_HAVE_IO_URING
+	if(_engine->_ring) destroy_Ring(( IO_Ring* ) _engine->_ring);
+#endif
+	pthread_cond_destroy(&_engine->_done);
+	pthread_cond_destroy(&_engine->_work);
+	pthread_mutex_destroy(&_engine->_mutex);
+	free(_engine->_memory);
+	free(_engine->_buffers);
+	free(_engine);
+}
+
+int uses_IO_Uring(const LHC_IO_Engine *_engine) {
+	return _engine->_ring!=NULL;
+}
+
+/** Function to open (create / truncate) a file written through the engine */
+LHC_IO_File* open_IO_File(LHC_IO_Engine *_engine, const char *_name) {
+
+	LHC_IO_File* _file;
+
+	(void)_engine;
+	_file = ( LHC_IO_File* ) calloc( 1, sizeof( LHC_IO_File ) );
+	if(!_file) return NULL;
+	_file->_fd = open(_name, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+	if(_file->_fd<0) {
+		int _error = errno;
+		free(_file);
+		errno = _error;
+		return NULL;
+	}
+	return _file;
+}
+
+/** Function to wait for all the writes of a file, and close it */
+int close_IO_File(LHC_IO_Engine *_engine, LHC_IO_File *_file) {
+
+	int _error;
+
+	pthread_mutex_lock(&_engine->_mutex);
+	while(_file->_pending>0) pthread_cond_wait(&_engine->_done, &_engine->_mutex);
+	pthread_mutex_unlock(&_engine->_mutex);
+
+	_error = _file->_error;
+	if(close(_file->_fd)!=0 && _error==0) _error = errno;
+	free(_file);
+
+	return _error;
+}
+
+/** Function to take an empty buffer. When all of them are queued, the caller waits for the
+ *  engine to write one (this is how a slow disk slows down the writers, never the capture). */
+LHC_IO_Buffer* get_IO_Buffer(LHC_IO_Engine *_engine) {
+
+	LHC_IO_Buffer* _buffer;
+
+	pthread_mutex_lock(&_engine->_mutex);
+	while(!_engine->_free) pthread_cond_wait(&_engine->_done, &_engine->_mutex);
+	_buffer = _engine->_free;
+	_engine->_free = _buffer->_next;
+	pthread_mutex_unlock(&_engine->_mutex);
+
+	_buffer->_next = NULL;
+	_buffer->_length = 0;
+	_buffer->_done = 0;
+
+	return _buffer;
+}
+
+/** Function to hand a filled buffer to the engine. The buffer is appended to the file: its
+ *  offset is reserved now, so the engine may write the buffers in any order. */
+void submit_IO_Buffer(LHC_IO_Engine *_engine, LHC_IO_File *_file, LHC_IO_Buffer *_buffer) {
+
+	pthread_mutex_lock(&_engine->_mutex);
+	_buffer->_file = _file;
+	_buffer->_offset = _file->_offset;
+	_buffer->_done = 0;
+	_file->_offset += _buffer->_length;
+	_file->_pending++;
+
+	if(_buffer->_length==0) complete_Buffer(_engine, _buffer, 0);
+	else {
+		_buffer->_next = NULL;
+		if(_engine->_queue_Tail) _engine->_queue_Tail->_next = _buffer;
+		else 					 _engine->_queue_Head = _buffer;
+		_engine->_queue_Tail = _buffer;
+		pthread_cond_signal(&_engine->_work);
+	}
+	pthread_mutex_unlock(&_engine->_mutex);
+}
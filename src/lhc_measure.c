@@ -0,0 +1,325 @@
+//==============================================================================//
+//  Filename: lhc_measure.c														//
+//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+/* Local includes */
+#include "../include/lhc_simulator.h"
+#include "../include/lhc_measure.h"
+
+#define INT16_STEPS 65535.0f
+#define PREFAULT_PAGE 4096				/* Smallest page the columns are touched by. */
+
+/** Function to convert a float to IEEE half, rounding to nearest even */
+uint16_t float_To_Half(float _value) {
+
+	uint32_t _bits, _sign, _mantissa, _rest, _halfway;
+	int32_t  _exponent;
+	uint16_t _half;
+
+	memcpy(&_bits, &_value, sizeof(_bits));
+	_sign = (_bits>>16) & 0x8000;
+	_exponent = (int32_t)((_bits>>23) & 0xff) - 127 + 15;
+	_mantissa = _bits & 0x7fffff;
+
+	if(((_bits>>23) & 0xff)==0xff) return _sign | 0x7c00 | (_mantissa ? 0x200 : 0);	/** Inf / NaN */
+	if(_exponent>=31) return _sign | 0x7c00;											/** Overflow */
+	if(_exponent<=0) {																	/** Subnormal */
+		unsigned int _shift = 14 - _exponent;
+
+		if(_exponent < -10) return _sign;
+		_mantissa |= 0x800000;
+		_half = _mantissa >> _shift;
+		_rest = _mantissa & ((1u<<_shift)-1);
+		_halfway = 1u<<(_shift-1);
+		if(_rest>_halfway || (_rest==_halfway && (_half & 1))) _half++;
+		return _sign | _half;
+	}
+
+	/** A carry out of the mantissa correctly bumps the exponent */
+	_half = _sign | (_exponent<<10) | (_mantissa>>13);
+	_rest = _mantissa & 0x1fff;
+	if(_rest>0x1000 || (_rest==0x1000 && (_half & 1))) _half++;
+
+	return _half;
+}
+
+/** Function to convert an IEEE half to float (exact) */
+float half_To_Float(uint16_t _half) {
+
+	uint32_t _sign = (uint32_t)(_half & 0x8000)<<16, _mantissa = _half & 0x3ff, _bits;
+	int32_t  _exponent = (_half>>10) & 0x1f;
+	float	 _value;
+
+	if(_exponent==0) {
+		if(_mantissa==0) _bits = _sign;
+		else {
+			/** Subnormal half: normalized as a float */
+			_exponent = 1;
+			while(!(_mantissa & 0x400)) {
+				_mantissa <<= 1;
+				_exponent--;
+			}
+			_bits = _sign | (uint32_t)(_exponent+112)<<23 | (_mantissa & 0x3ff)<<13;
+		}
+	}
+	else if(_exponent==31) _bits = _sign | 0x7f800000 | _mantissa<<13;
+	else 				   _bits = _sign | (uint32_t)(_exponent+112)<<23 | _mantissa<<13;
+
+	memcpy(&_value, &_bits, sizeof(_value));
+	return _value;
+}
+
+void default_Channel_Formats(LHC_Channel_Format *_formats) {
+
+	unsigned int _channel;
+
+	for(_channel=0;_channel<LHC_CHANNELS;_channel++) {
+		_formats[_channel]._precision = LHC_PRECISION_FLOAT32;
+		_formats[_channel]._min = 0.0f;
+		_formats[_channel]._max = 1.0f;
+		_formats[_channel]._period = 0.0f;
+		_formats[_channel]._deadband = 0.0f;
+	}
+}
+
+void multirate_Channel_Formats(LHC_Channel_Format *_formats) {
+
+	default_Channel_Formats(_formats);
+
+	/** Cryogenics move over seconds */
+	_formats[LHC_HELIUM_TEMP]._period = 0.1f;
+	_formats[LHC_HELIUM_TEMP]._deadband = 0.002f;
+	_formats[LHC_HELIUM_PRESSURE]._period = 0.1f;
+	_formats[LHC_HELIUM_PRESSURE]._deadband = 0.002f;
+
+	/** Flat channels: every revolution is looked at, only the moves are kept */
+	_formats[LHC_PARTICLE_SPEED]._deadband = 0.005f;
+	_formats[LHC_MAGNET_CURRENT]._deadband = 0.02f;
+}
+
+size_t precision_Size(LHC_Precision _precision) {
+	return (_precision==LHC_PRECISION_FLOAT32) ? sizeof(float) : sizeof(uint16_t);
+}
+
+/** Function to write one byte per page of a block: a fresh calloc may only map the zero
+ *  page, and the real pages would be faulted in one by one during the capture */
+static void prefault_Memory(void *_data, size_t _size) {
+
+	volatile char*	p = ( volatile char* ) _data;
+	size_t			_offset;
+
+	for(_offset=0;_offset<_size;_offset+=PREFAULT_PAGE) p[_offset] = 0;
+}
+
+/** Function to allocate the columns of a node. Every page is faulted in now (by the thread
+ *  of the node) instead of during the capture. */
+int allocate_Channels(LHC_Node *_lhc_Node, const LHC_Channel_Format *_formats) {
+
+	unsigned int _channel, _capacity;
+	float _stride;
+
+	for(_channel=0;_channel<LHC_CHANNELS;_channel++) {
+		LHC_Channel_Store* _store = &_lhc_Node->_channels[_channel];
+
+		_store->_precision = _formats[_channel]._precision;
+		_store->_min = _formats[_channel]._min;
+		_store->_scale = (_formats[_channel]._max - _formats[_channel]._min)/INT16_STEPS;
+		if(!(_store->_scale>0)) _store->_scale = 1.0f/INT16_STEPS;
+
+		/** The period of the channel, in revolutions of the node */
+		_stride = (_lhc_Node->_cadence>0) ? _formats[_channel]._period/_lhc_Node->_cadence : 0.0f;
+		_store->_stride = (_stride>1.0f) ? (_stride<_lhc_Node->_number_Of_Measures ? (unsigned int)(_stride+0.5f) : _lhc_Node->_number_Of_Measures) : 1;
+		_store->_deadband = (_formats[_channel]._deadband>0) ? _formats[_channel]._deadband : 0.0f;
+		_store->_last = 0.0f;
+		_store->_count = 0;
+		_store->_turns = NULL;
+
+		/** Sparse: room for the first measure and every multiple of the stride */
+		_capacity = _lhc_Node->_number_Of_Measures;
+		if(_store->_stride>1 || _store->_deadband>0) {
+			_capacity = _lhc_Node->_number_Of_Measures/_store->_stride + 2;
+			_store->_turns = ( uint32_t* ) calloc( _capacity, sizeof( uint32_t ) );
+		}
+		_store->_data = calloc( _capacity, precision_Size(_store->_precision) );
+		if(_store->_data) prefault_Memory(_store->_data, (size_t)_capacity*precision_Size(_store->_precision));
+		if(_store->_turns) prefault_Memory(_store->_turns, (size_t)_capacity*sizeof( uint32_t ));
+	}
+	for(_channel=0;_channel<LHC_CHANNELS;_channel++) {
+		const LHC_Channel_Store* _store = &_lhc_Node->_channels[_channel];
+
+		if(!_store->_data || ((_store->_stride>1 || _store->_deadband>0) && !_store->_turns)) {
+			free_Channels(_lhc_Node);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+void free_Channels(LHC_Node *_lhc_Node) {
+
+	unsigned int _channel;
+
+	for(_channel=0;_channel<LHC_CHANNELS;_channel++) {
+		free(_lhc_Node->_channels[_channel]._data);
+		free(_lhc_Node->_channels[_channel]._turns);
+		_lhc_Node->_channels[_channel]._data = NULL;
+		_lhc_Node->_channels[_channel]._turns = NULL;
+	}
+}
+
+size_t channel_Bytes(const LHC_Node *_lhc_Node, LHC_Channel _channel) {
+
+	const LHC_Channel_Store* _store = &_lhc_Node->_channels[_channel];
+
+	if(_store->_turns) return (size_t)_store->_count*(precision_Size(_store->_precision) + sizeof(uint32_t));
+	return (size_t)_lhc_Node->_number_Of_Measures*precision_Size(_store->_precision);
+}
+
+/** Function to store one value of a channel */
+static inline void encode_Value(LHC_Channel_Store *_store, unsigned int i, float _value) {
+
+	switch(_store->_precision) {
+	case LHC_PRECISION_FLOAT16:
+		((uint16_t*)_store->_data)[i] = float_To_Half(_value);
+		break;
+	case LHC_PRECISION_INT16: {
+		float _steps = (_value - _store->_min)/_store->_scale;
+
+		if(!(_steps>0)) _steps = 0;								/** NaN goes to _min */
+		if(_steps>INT16_STEPS) _steps = INT16_STEPS;
+		((uint16_t*)_store->_data)[i] = (uint16_t)(_steps + 0.5f);
+		break;
+	}
+	default:
+		((float*)_store->_data)[i] = _value;
+	}
+}
+
+/** Function to store the value of measure 'i' (revolution '_turn') of a channel. A sparse
+ *  channel always keeps its first sample, then the due ones that moved past the deadband. */
+static inline void store_Value(LHC_Channel_Store *_store, unsigned int i, unsigned int _turn, float _value) {
+
+	if(!_store->_turns) {
+		encode_Value(_store, i, _value);
+		return;
+	}
+	if(_store->_count>0 && (_turn%_store->_stride!=0 || !(fabsf(_value - _store->_last) > _store->_deadband))) return;
+
+	_store->_turns[_store->_count] = i;
+	encode_Value(_store, _store->_count++, _value);
+	_store->_last = _value;
+}
+
+/** Function to know the sample held at measure 'i' of a sparse channel: the last one taken
+ *  at or before it (the first sample is taken at the first measure) */
+static inline unsigned int held_Sample(const LHC_Channel_Store *_store, unsigned int i) {
+
+	unsigned int _low = 0, _high = _store->_count, _middle;
+
+	while(_high - _low > 1) {
+		_middle = (_low + _high)/2;
+		if(_store->_turns[_middle] <= i) _low = _middle;
+		else 							 _high = _middle;
+	}
+	return _low;
+}
+
+/** Function to read one stored value of a channel */
+static inline float decode_Sample(const LHC_Channel_Store *_store, unsigned int i) {
+
+	switch(_store->_precision) {
+	case LHC_PRECISION_FLOAT16: return half_To_Float(((const uint16_t*)_store->_data)[i]);
+	case LHC_PRECISION_INT16:	return _store->_min + ((const uint16_t*)_store->_data)[i]*_store->_scale;
+	default:					return ((const float*)_store->_data)[i];
+	}
+}
+
+/** Function to read the value of a channel at measure 'i' */
+static inline float decode_Value(const LHC_Channel_Store *_store, unsigned int i) {
+
+	if(!_store->_turns) return decode_Sample(_store, i);
+	if(_store->_count==0) return 0.0f;
+	return decode_Sample(_store, held_Sample(_store, i));
+}
+
+void encode_Measure(LHC_Node *_lhc_Node, unsigned int i, const Measure *_measure) {
+
+	LHC_Channel_Store* _channels = _lhc_Node->_channels;
+	unsigned int _turn = _lhc_Node->_first_Turn + i;
+
+	store_Value(&_channels[LHC_PARTICLE_RADIATION], i, _turn, _measure->_particle_Radiation);
+	store_Value(&_channels[LHC_PARTICLE_SPEED], i, _turn, _measure->_particle_Speed);
+	store_Value(&_channels[LHC_MAGNET_CURRENT], i, _turn, _measure->_magnet_Current);
+	store_Value(&_channels[LHC_HELIUM_TEMP], i, _turn, _measure->_helium_Temp);
+	store_Value(&_channels[LHC_HELIUM_PRESSURE], i, _turn, _measure->_helium_Pressure);
+	store_Value(&_channels[LHC_PHASE_RF], i, _turn, _measure->_phase_RF);
+}
+
+int channel_Due(const LHC_Node *_lhc_Node, LHC_Channel _channel, unsigned int i) {
+
+	const LHC_Channel_Store* _store = &_lhc_Node->_channels[_channel];
+
+	return _store->_stride<=1 || _store->_count==0 || (_lhc_Node->_first_Turn + i)%_store->_stride==0;
+}
+
+void encode_Channel(LHC_Node *_lhc_Node, LHC_Channel _channel, unsigned int i, float _value) {
+	store_Value(&_lhc_Node->_channels[_channel], i, _lhc_Node->_first_Turn + i, _value);
+}
+
+void decode_Measure(const LHC_Node *_lhc_Node, unsigned int i, Measure *_measure) {
+
+	const LHC_Channel_Store* _channels = _lhc_Node->_channels;
+
+	/** Node metadata is the same for every measure */
+	_measure->_identifier = _lhc_Node->_identifier;
+	_measure->_position = _lhc_Node->_position;
+
+	_measure->_particle_Radiation = decode_Value(&_channels[LHC_PARTICLE_RADIATION], i);
+	_measure->_particle_Speed = decode_Value(&_channels[LHC_PARTICLE_SPEED], i);
+	_measure->_magnet_Current = decode_Value(&_channels[LHC_MAGNET_CURRENT], i);
+	_measure->_helium_Temp = decode_Value(&_channels[LHC_HELIUM_TEMP], i);
+	_measure->_helium_Pressure = decode_Value(&_channels[LHC_HELIUM_PRESSURE], i);
+	_measure->_phase_RF = decode_Value(&_channels[LHC_PHASE_RF], i);
+}
+
+/** Function to read a run of values of one channel (the loops are simple enough for the
+ *  compiler to vectorise the float32 and int16 cases) */
+void decode_Channel(const LHC_Node *_lhc_Node, LHC_Channel _channel, unsigned int _first, unsigned int _count, float *_out) {
+
+	const LHC_Channel_Store* _store = &_lhc_Node->_channels[_channel];
+	unsigned int i, k;
+
+	/** Sparse: every sample is held until the next one */
+	if(_store->_turns) {
+		if(_store->_count==0) {
+			memset(_out, 0, _count*sizeof(float));
+			return;
+		}
+		k = held_Sample(_store, _first);
+		for(i=0;i<_count;i++) {
+			while(k+1<_store->_count && _store->_turns[k+1] <= _first+i) k++;
+			_out[i] = decode_Sample(_store, k);
+		}
+		return;
+	}
+
+	switch(_store->_precision) {
+	case LHC_PRECISION_FLOAT16: {
+		const uint16_t* _data = ( const uint16_t* ) _store->_data + _first;
+		for(i=0;i<_count;i++) _out[i] = half_To_Float(_data[i]);
+		break;
+	}
+	case LHC_PRECISION_INT16: {
+		const uint16_t* _data = ( const uint16_t* ) _store->_data + _first;
+		float _min = _store->_min, _scale = _store->_scale;
+		for(i=0;i<_count;i++) _out[i] = _min + _data[i]*_scale;
+		break;
+	}
+	default:
+		memcpy(_out, ( const float* ) _store->_data + _first, _count*sizeof(float));
+	}
+}
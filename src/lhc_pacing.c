@@ -0,0 +1,139 @@
+//==============================================================================//
+//  Filename: lhc_pacing.c														//
+//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+/* Local includes */
+#include "../include/lhc_pacing.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NS_PER_S 1000000000LL
+
+/** Function to read CLOCK_MONOTONIC in ns */
+int64_t monotonic_Now(void) {
+
+	struct timespec _now;
+
+	clock_gettime(CLOCK_MONOTONIC, &_now);
+	return (int64_t)_now.tv_sec*NS_PER_S + _now.tv_nsec;
+}
+
+/** Function to know the bucket of a value in ns */
+unsigned int pacing_Bucket(int64_t _ns) {
+
+	unsigned int _bucket;
+
+	if(_ns<=0) return 0;
+	_bucket = 64 - __builtin_clzll((unsigned long long)_ns);
+
+	return (_bucket<LHC_PACING_BUCKETS) ? _bucket : LHC_PACING_BUCKETS-1;
+}
+
+void clear_Pacing_Stats(LHC_Pacing_Stats *_stats) {
+
+	memset(_stats, 0, sizeof(LHC_Pacing_Stats));
+	_stats->_lateness_Min = INT64_MAX;
+	_stats->_lateness_Max = INT64_MIN;
+}
+
+void merge_Pacing_Stats(LHC_Pacing_Stats *_total, const LHC_Pacing_Stats *_stats) {
+
+	unsigned int b;
+
+	_total->_captures += _stats->_captures;
+	_total->_missed += _stats->_missed;
+	_total->_lateness_Sum += _stats->_lateness_Sum;
+	if(_stats->_lateness_Min < _total->_lateness_Min) _total->_lateness_Min = _stats->_lateness_Min;
+	if(_stats->_lateness_Max > _total->_lateness_Max) _total->_lateness_Max = _stats->_lateness_Max;
+	for(b=0;b<LHC_PACING_BUCKETS;b++) {
+		_total->_lateness_Histogram[b] += _stats->_lateness_Histogram[b];
+		_total->_jitter_Histogram[b] += _stats->_jitter_Histogram[b];
+	}
+}
+
+/** Function to set a pacer. The deadline of revolution 'i' is origin + offset + i*period. */
+void init_Pacer(LHC_Pacer *_pacer, int64_t _origin, double _period, double _offset, int64_t _spin) {
+
+	_pacer->_origin = _origin + (int64_t)_offset;
+	_pacer->_period = _period;
+	_pacer->_spin = _spin;
+	_pacer->_overshoot = 0;
+	_pacer->_last_Lateness = 0;
+	clear_Pacing_Stats(&_pacer->_stats);
+}
+
+/** Function to wait for the deadline of revolution 'i'. The node sleeps on the absolute
+ *  deadline (minus the spin margin and the expected oversleep), then spins the rest, so
+ *  even sub-microsecond slots are met when the machine keeps up. */
+int64_t wait_Pacer(LHC_Pacer *_pacer, unsigned long i) {
+
+	int64_t _deadline = _pacer->_origin + (int64_t)(i*_pacer->_period);
+	int64_t _wake = _deadline - _pacer->_spin - _pacer->_overshoot;
+	int64_t _now = monotonic_Now(), _lateness;
+	LHC_Pacing_Stats* _stats = &_pacer->_stats;
+
+	if(_now < _wake) {
+		struct timespec _until;
+
+		_until.tv_sec = _wake / NS_PER_S;
+		_until.tv_nsec = _wake % NS_PER_S;
+		while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &_until, NULL)==EINTR);
+
+		/** The oversleep estimation follows the kernel wake-up latency (1/8 smoothing) */
+		_now = monotonic_Now();
+		_pacer->_overshoot += ((_now - _wake) - _pacer->_overshoot)/8;
+		if(_pacer->_overshoot<0) _pacer->_overshoot = 0;
+	}
+	while(_now < _deadline) _now = monotonic_Now();
+
+	/** Accounting */
+	_lateness = _now - _deadline;
+	_stats->_captures++;
+	if(_lateness > (int64_t)_pacer->_period) _stats->_missed++;
+	if(_lateness < _stats->_lateness_Min) _stats->_lateness_Min = _lateness;
+	if(_lateness > _stats->_lateness_Max) _stats->_lateness_Max = _lateness;
+	_stats->_lateness_Sum += _lateness;
+	_stats->_lateness_Histogram[pacing_Bucket(_lateness)]++;
+	if(_stats->_captures>1)
+		_stats->_jitter_Histogram[pacing_Bucket(llabs(_lateness - _pacer->_last_Lateness))]++;
+	_pacer->_last_Lateness = _lateness;
+
+	return _lateness;
+}
+
+/** Function to print one histogram (only the buckets with something inside) */
+void print_Histogram(FILE *_fp, const char *_name, const unsigned long *_histogram) {
+
+	unsigned int b;
+
+	fprintf(_fp, "  %-8s", _name);
+	for(b=0;b<LHC_PACING_BUCKETS;b++) {
+		if(_histogram[b]==0) continue;
+		if(b==LHC_PACING_BUCKETS-1) fprintf(_fp, " >=%lldns:%lu", 1LL<<(b-1), _histogram[b]);
+		else 						fprintf(_fp, " <%lldns:%lu", 1LL<<b, _histogram[b]);
+	}
+	fprintf(_fp, "\n");
+}
+
+void print_Pacing_Stats(FILE *_fp, const LHC_Pacing_Stats *_stats, int _identifier) {
+
+	if(_identifier<0) fprintf(_fp, "All nodes:");
+	else 			  fprintf(_fp, "Node %d:", _identifier);
+
+	if(_stats->_captures==0) {
+		fprintf(_fp, " no captures.\n");
+		return;
+	}
+	fprintf(_fp, " %lu captures, %lu missed revolutions, lateness min %lld / mean %.0f / max %lld ns.\n",
+			_stats->_captures, _stats->_missed,
+			(long long)_stats->_lateness_Min, _stats->_lateness_Sum/_stats->_captures,
+			(long long)_stats->_lateness_Max);
+	print_Histogram(_fp, "lateness", _stats->_lateness_Histogram);
+	print_Histogram(_fp, "jitter", _stats->_jitter_Histogram);
+}
@@ -0,0 +1,152 @@
+//==============================================================================//
+//  Filename: lhc_ring.c														//
+//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+/* Local includes */
+#include "../include/lhc_ring.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*  RING  */
+/*~~~~~~~~*/
+/** Function to allocate a ring of 'n' members */
+static LHC_Ring* allocate_Ring(unsigned int n) {
+
+	LHC_Ring* _ring = ( LHC_Ring* ) malloc( sizeof( LHC_Ring ) + n*sizeof( LHC_Ring_Member ) );
+
+	if(_ring) _ring->_number_Of_Members = n;
+	return _ring;
+}
+
+/** Order in which the particle meets the members */
+static int before_Member(const LHC_Ring_Member *_a, const LHC_Ring_Member *_b) {
+	return _a->_position < _b->_position || (_a->_position == _b->_position && _a->_identifier < _b->_identifier);
+}
+
+LHC_Ring* create_Ring(void) {
+	return allocate_Ring(0);
+}
+
+LHC_Ring* insert_Ring_Member(const LHC_Ring *_ring, unsigned int _identifier, float _position) {
+
+	LHC_Ring* 		_copy = allocate_Ring(_ring->_number_Of_Members+1);
+	LHC_Ring_Member	_member = { _identifier, _position };
+	unsigned int	i, j=0;
+
+	if(!_copy) return NULL;
+	for(i=0;i<_ring->_number_Of_Members && before_Member(&_ring->_members[i], &_member);i++)
+		_copy->_members[j++] = _ring->_members[i];
+	_copy->_members[j++] = _member;
+	for(;i<_ring->_number_Of_Members;i++) _copy->_members[j++] = _ring->_members[i];
+
+	return _copy;
+}
+
+LHC_Ring* remove_Ring_Member(const LHC_Ring *_ring, unsigned int _identifier) {
+
+	LHC_Ring*	_copy;
+	int			_index = find_Ring_Member(_ring, _identifier);
+
+	if(_index<0) {
+		errno = ENOENT;
+		return NULL;
+	}
+	_copy = allocate_Ring(_ring->_number_Of_Members-1);
+	if(!_copy) return NULL;
+	memcpy(_copy->_members, _ring->_members, _index*sizeof(LHC_Ring_Member));
+	memcpy(_copy->_members+_index, _ring->_members+_index+1, (_ring->_number_Of_Members-_index-1)*sizeof(LHC_Ring_Member));
+
+	return _copy;
+}
+
+int find_Ring_Member(const LHC_Ring *_ring, unsigned int _identifier) {
+
+	unsigned int i;
+
+	for(i=0;i<_ring->_number_Of_Members;i++)
+		if(_ring->_members[i]._identifier==_identifier) return (int)i;
+	return -1;
+}
+
+
+/*  EPOCHS  */
+/*~~~~~~~~~~*/
+int init_Epoch(LHC_Epoch *_epoch, unsigned int _readers) {
+
+	_epoch->_global = 1;
+	_epoch->_number_Of_Readers = _readers;
+	_epoch->_retired = NULL;
+	_epoch->_readers = ( LHC_Epoch_Reader* ) aligned_alloc( sizeof( LHC_Epoch_Reader ), (_readers ? _readers : 1)*sizeof( LHC_Epoch_Reader ) );
+	if(!_epoch->_readers) return -1;
+	memset(_epoch->_readers, 0, _readers*sizeof( LHC_Epoch_Reader ));
+
+	return 0;
+}
+
+void destroy_Epoch(LHC_Epoch *_epoch) {
+
+	LHC_Retired* _retired;
+
+	while((_retired = _epoch->_retired)) {
+		_epoch->_retired = _retired->_next;
+		free(_retired->_object);
+		free(_retired);
+	}
+	free(_epoch->_readers);
+	_epoch->_readers = NULL;
+}
+
+/** The store of the reader epoch must be visible before any pointer is read (hence the
+ *  full barrier): a writer either sees the reader, or the reader sees the new pointer. */
+void enter_Epoch(LHC_Epoch *_epoch, unsigned int _reader) {
+	__atomic_store_n(&_epoch->_readers[_reader]._epoch, __atomic_load_n(&_epoch->_global, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void exit_Epoch(LHC_Epoch *_epoch, unsigned int _reader) {
+	__atomic_store_n(&_epoch->_readers[_reader]._epoch, 0, __ATOMIC_RELEASE);
+}
+
+/** The object is tagged with the current epoch, then the epoch moves on: readers entering
+ *  from now on cannot find the object any more. */
+int retire_Epoch(LHC_Epoch *_epoch, void *_object) {
+
+	LHC_Retired* _retired = ( LHC_Retired* ) malloc( sizeof( LHC_Retired ) );
+
+	if(!_retired) return -1;
+	_retired->_object = _object;
+	_retired->_epoch = __atomic_fetch_add(&_epoch->_global, 1, __ATOMIC_SEQ_CST);
+	_retired->_next = _epoch->_retired;
+	_epoch->_retired = _retired;
+
+	return 0;
+}
+
+/** An object retired at epoch 'e' is freed once no reader is inside a section entered at
+ *  an epoch <= e */
+void collect_Epoch(LHC_Epoch *_epoch) {
+
+	LHC_Retired**	_link = &_epoch->_retired;
+	LHC_Retired*	_retired;
+	uint64_t		_oldest = UINT64_MAX, _reader;
+	unsigned int	i;
+
+	for(i=0;i<_epoch->_number_Of_Readers;i++) {
+		_reader = __atomic_load_n(&_epoch->_readers[i]._epoch, __ATOMIC_SEQ_CST);
+		if(_reader!=0 && _reader<_oldest) _oldest = _reader;
+	}
+
+	while((_retired = *_link)) {
+		if(_retired->_epoch < _oldest) {
+			*_link = _retired->_next;
+			free(_retired->_object);
+			free(_retired);
+		} else _link = &_retired->_next;
+	}
+}
@@ -0,0 +1,330 @@
+//==============================================================================//
+//  Filename: lhc_sensor.c														//
+//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+/* Local includes */
+#include "../include/lhc_sensor.h"
+
+#include <math.h>
+#include <string.h>
+#include <errno.h>
+
+#define TWO_PI 6.28318530717958647692f
+
+/** sin(2pi*x) for x in [0,1): reduced to [-1/4,1/4] and a Taylor polynomial up to z^11 */
+static inline float turn_Sin(float x) {
+
+	float y = x - 0.5f, z, z2;
+
+	y = (y > 0.25f) ? 0.5f - y : ((y < -0.25f) ? -0.5f - y : y);
+	z = TWO_PI*y;
+	z2 = z*z;
+
+	/** sin(2pi(y+1/2)) = -sin(2pi y) */
+	return -z*(1.0f + z2*(-1.0f/6 + z2*(1.0f/120 + z2*(-1.0f/5040 + z2*(1.0f/362880 + z2*(-1.0f/39916800))))));
+}
+
+/** Function to compose 'm' steps of an AR1: x[t+m] = offset + phi^m*(x[t]-offset) + gain*noise,
+ *  the gain keeping the deviation of the 'm' noises summed (sqrt(m) for a random walk) */
+static void ar1_Steps(float _phi, unsigned int m, float *_phi_M, float *_gain_M) {
+
+	double _phi2 = (double)_phi*_phi;
+
+	if(m<=1) {
+		*_phi_M = _phi;
+		*_gain_M = 1.0f;
+		return;
+	}
+	*_phi_M = (float)pow(_phi, m);
+	*_gain_M = (float)sqrt(fabs(1.0 - _phi2)<1e-9 ? (double)m : (1.0 - pow(_phi2, m))/(1.0 - _phi2));
+}
+
+
+/*  MODELS  */
+/*~~~~~~~~~~*/
+void default_Sensor_Models(LHC_Sensor_Model *_models) {
+
+	unsigned int _channel;
+
+	memset(_models, 0, LHC_CHANNELS*sizeof(LHC_Sensor_Model));
+	for(_channel=0;_channel<LHC_CHANNELS;_channel++) {
+		_models[_channel]._kind = LHC_SENSOR_WHITE;
+		_models[_channel]._offset = 0.0f;
+		_models[_channel]._amplitude = 1.0f;
+		_models[_channel]._step_Node = -1;
+	}
+}
+
+void realistic_Sensor_Models(LHC_Sensor_Model *_models) {
+
+	default_Sensor_Models(_models);
+
+	/** Radiation: noisy, quickly forgetting */
+	_models[LHC_PARTICLE_RADIATION]._kind = LHC_SENSOR_AR1;
+	_models[LHC_PARTICLE_RADIATION]._offset = 0.3f;
+	_models[LHC_PARTICLE_RADIATION]._phi = 0.98f;
+	_models[LHC_PARTICLE_RADIATION]._sigma = 0.02f;
+
+	/** Speed: almost constant, slowly wandering */
+	_models[LHC_PARTICLE_SPEED]._kind = LHC_SENSOR_AR1;
+	_models[LHC_PARTICLE_SPEED]._offset = 0.9f;
+	_models[LHC_PARTICLE_SPEED]._phi = 0.995f;
+	_models[LHC_PARTICLE_SPEED]._sigma = 0.002f;
+
+	/** Magnet current: flat, with a fault at node 0 after 500 turns */
+	_models[LHC_MAGNET_CURRENT]._kind = LHC_SENSOR_STEP;
+	_models[LHC_MAGNET_CURRENT]._offset = 0.6f;
+	_models[LHC_MAGNET_CURRENT]._amplitude = 0.1f;
+	_models[LHC_MAGNET_CURRENT]._sigma = 0.005f;
+	_models[LHC_MAGNET_CURRENT]._step_Turn = 500;
+	_models[LHC_MAGNET_CURRENT]._step_Node = 0;
+
+	/** Helium temperature: slow thermal drift */
+	_models[LHC_HELIUM_TEMP]._kind = LHC_SENSOR_THERMAL;
+	_models[LHC_HELIUM_TEMP]._offset = 0.2f;
+	_models[LHC_HELIUM_TEMP]._amplitude = 0.1f;
+	_models[LHC_HELIUM_TEMP]._tau = 20000.0f;
+	_models[LHC_HELIUM_TEMP]._sigma = 0.002f;
+
+	/** Helium pressure: random walk */
+	_models[LHC_HELIUM_PRESSURE]._kind = LHC_SENSOR_AR1;
+	_models[LHC_HELIUM_PRESSURE]._offset = 0.5f;
+	_models[LHC_HELIUM_PRESSURE]._phi = 1.0f;
+	_models[LHC_HELIUM_PRESSURE]._sigma = 0.001f;
+
+	/** RF phase: sinusoidal drift seen with the delay of each node */
+	_models[LHC_PHASE_RF]._kind = LHC_SENSOR_SINE;
+	_models[LHC_PHASE_RF]._offset = 0.5f;
+	_models[LHC_PHASE_RF]._amplitude = 0.2f;
+	_models[LHC_PHASE_RF]._frequency = 0.001f;
+	_models[LHC_PHASE_RF]._sigma = 0.01f;
+}
+
+void init_Sensor_Lane(LHC_Sensor_Lane *_lane, const LHC_Sensor_Model *_models, unsigned int _identifier, float _phase) {
+
+	unsigned int _channel;
+
+	_lane->_identifier = _identifier;
+	_lane->_phase = _phase;
+	for(_channel=0;_channel<LHC_CHANNELS;_channel++) {
+		_lane->_state[_channel] = _models[_channel]._offset;
+		_lane->_turn[_channel] = LHC_SENSOR_NO_TURN;
+	}
+}
+
+/** Function to generate 'n' values of a channel, one every '_stride' turns, for several lanes.
+ *  The outer loop runs over the lanes and the inner one over contiguous values; only AR1 keeps
+ *  a (cheap) recurrence, its noise being drawn in a vector loop first. */
+void generate_Sensor(const LHC_Sensor_Model *_model, uint64_t _seed, LHC_Sensor_Lane *_lanes, unsigned int _number_Of_Lanes,
+		LHC_Channel _channel, unsigned int _first, unsigned int n, unsigned int _stride, float *_out) {
+
+	unsigned int _l, k;
+
+	if(n==0) return;
+	if(_stride==0) _stride = 1;
+
+	for(_l=0;_l<_number_Of_Lanes;_l++) {
+		LHC_Sensor_Lane* _lane = &_lanes[_l];
+		float* _o = _out + (size_t)_l*n;
+		uint32_t _identifier = _lane->_identifier;
+
+		switch(_model->_kind) {
+		case LHC_SENSOR_AR1: {
+			float _x = _lane->_state[_channel];
+			unsigned int _last = _lane->_turn[_channel];
+			float _phi_Gap, _gain_Gap, _phi_Stride, _gain_Stride;
+
+			/** The first value steps from the last one generated (one turn before the first) */
+			ar1_Steps(_model->_phi, (_last==LHC_SENSOR_NO_TURN || _first<=_last) ? 1 : _first - _last, &_phi_Gap, &_gain_Gap);
+			ar1_Steps(_model->_phi, _stride, &_phi_Stride, &_gain_Stride);
+
+			for(k=0;k<n;k++) _o[k] = _model->_sigma*hash_Gaussian(sensor_Hash(_seed, _identifier, _channel, _first+k*_stride));
+			_x = _model->_offset + _phi_Gap*(_x - _model->_offset) + _gain_Gap*_o[0];
+			_o[0] = _x;
+			for(k=1;k<n;k++) {
+				_x = _model->_offset + _phi_Stride*(_x - _model->_offset) + _gain_Stride*_o[k];
+				_o[k] = _x;
+			}
+			_lane->_state[_channel] = _x;
+			_lane->_turn[_channel] = _first + (n-1)*_stride;
+			break;
+		}
+		case LHC_SENSOR_SINE: {
+			/** Phase of the first turn in double (turns may be large), the rest in float */
+			double _base = fmod((double)_model->_frequency*_first + _lane->_phase, 1.0);
+			float _f = _model->_frequency;
+
+			for(k=0;k<n;k++) {
+				float x = (float)_base + _f*(float)(k*_stride);
+				x -= (float)(int)x;
+				_o[k] = _model->_offset + _model->_amplitude*turn_Sin(x) +
+						_model->_sigma*hash_Gaussian(sensor_Hash(_seed, _identifier, _channel, _first+k*_stride));
+			}
+			break;
+		}
+		case LHC_SENSOR_THERMAL: {
+			/** offset + amplitude*(1 - r^t): r^first once, then one product per turn */
+			float _r = (_model->_tau>0) ? expf(-1.0f/_model->_tau) : 0.0f;
+			float _decay = (float)pow(_r, _first);
+			float _r_Stride = (_stride==1) ? _r : (float)pow(_r, _stride);
+
+			for(k=0;k<n;k++) _o[k] = _model->_sigma*hash_Gaussian(sensor_Hash(_seed, _identifier, _channel, _first+k*_stride));
+			for(k=0;k<n;k++) {
+				_o[k] += _model->_offset + _model->_amplitude*(1.0f - _decay);
+				_decay *= _r_Stride;
+			}
+			break;
+		}
+		case LHC_SENSOR_STEP: {
+			int _faulty = (_model->_step_Node<0 || (unsigned int)_model->_step_Node==_identifier);
+
+			for(k=0;k<n;k++)
+				_o[k] = _model->_offset + ((_faulty && _first+k*_stride>=_model->_step_Turn) ? _model->_amplitude : 0.0f) +
+						_model->_sigma*hash_Gaussian(sensor_Hash(_seed, _identifier, _channel, _first+k*_stride));
+			break;
+		}
+		default:
+			for(k=0;k<n;k++)
+				_o[k] = _model->_offset + _model->_amplitude*hash_Uniform(sensor_Hash(_seed, _identifier, _channel, _first+k*_stride));
+		}
+	}
+}
+
+/** Function to generate the block of several lanes from turn 'first' on. A channel with a
+ *  stride gets the first turn (the first capture of a node takes every channel) and then only
+ *  the turns it is sampled at; '_pitch' separates the channels in '_block'. */
+static void generate_Block(const LHC_Sensor_Model *_models, uint64_t _seed, LHC_Sensor_Lane *_lanes, unsigned int _number_Of_Lanes,
+		unsigned int *_strides, unsigned int _first, unsigned int _count, unsigned int *_samples, float *_block, size_t _pitch) {
+
+	unsigned int _channel, _stride, _aligned;
+
+	for(_channel=0;_channel<LHC_CHANNELS;_channel++) {
+		float* _out = _block + _channel*_pitch;
+
+		_stride = _strides[_channel] ? _strides[_channel] : 1;
+		_strides[_channel] = _stride;
+		if(_stride==1) {
+			generate_Sensor(&_models[_channel], _seed, _lanes, _number_Of_Lanes, _channel, _first, _count, 1, _out);
+			_samples[_channel] = _count;
+			continue;
+		}
+
+		/** The first multiple of the stride after the first turn */
+		_aligned = (_first/_stride + 1)*_stride;
+		_samples[_channel] = 1 + ((_count>0 && _first+_count-1 >= _aligned) ? (_first+_count-1 - _aligned)/_stride + 1 : 0);
+		generate_Sensor(&_models[_channel], _seed, _lanes, _number_Of_Lanes, _channel, _first, 1, 1, _out);
+		generate_Sensor(&_models[_channel], _seed, _lanes, _number_Of_Lanes, _channel, _aligned, _samples[_channel]-1,
+				_stride, _out + _number_Of_Lanes);
+	}
+}
+
+/** Function to refill the block of a node from turn 'first' on */
+void fill_Sensor_Bank(LHC_Sensor_Bank *_bank, const LHC_Sensor_Model *_models, uint64_t _seed, unsigned int _first, unsigned int _count) {
+
+	if(_count>LHC_SENSOR_BLOCK) _count = LHC_SENSOR_BLOCK;
+	generate_Block(_models, _seed, &_bank->_lane, 1, _bank->_stride, _first, _count, _bank->_samples,
+			&_bank->_block[0][0], LHC_SENSOR_BLOCK);
+	_bank->_first = _first;
+	_bank->_count = _count;
+}
+
+
+/*  GROUPS  */
+/*~~~~~~~~~~*/
+int init_Sensor_Group(LHC_Sensor_Group *_group, unsigned int _number_Of_Lanes) {
+
+	int _error;
+	unsigned int _lane;
+
+	if(_number_Of_Lanes==0 || _number_Of_Lanes>LHC_SENSOR_LANES) return EINVAL;
+	if((_error = pthread_mutex_init(&_group->_mutex, NULL))!=0) return _error;
+	if((_error = pthread_cond_init(&_group->_copied, NULL))!=0) {
+		pthread_mutex_destroy(&_group->_mutex);
+		return _error;
+	}
+	_group->_number_Of_Lanes = _number_Of_Lanes;
+	_group->_members = _number_Of_Lanes;
+	_group->_next = 0;
+	for(_lane=0;_lane<LHC_SENSOR_LANES;_lane++) _group->_last[_lane] = LHC_SENSOR_NO_TURN;
+	_group->_slots[0]._index = _group->_slots[1]._index = LHC_SENSOR_NO_TURN;
+	_group->_slots[0]._readers = _group->_slots[1]._readers = 0;
+
+	return 0;
+}
+
+void destroy_Sensor_Group(LHC_Sensor_Group *_group) {
+	pthread_cond_destroy(&_group->_copied);
+	pthread_mutex_destroy(&_group->_mutex);
+}
+
+/** Function to copy the values of a lane out of a slot */
+static void copy_Sensor_Slot(const LHC_Sensor_Slot *_slot, unsigned int _number_Of_Lanes, unsigned int _lane, LHC_Sensor_Bank *_bank) {
+
+	unsigned int _channel, n;
+
+	for(_channel=0;_channel<LHC_CHANNELS;_channel++) {
+		const float* _in = _slot->_block[_channel];
+
+		n = _slot->_samples[_channel];
+		if(_bank->_stride[_channel]<=1) memcpy(_bank->_block[_channel], _in + (size_t)_lane*n, n*sizeof(float));
+		else {
+			_bank->_block[_channel][0] = _in[_lane];
+			memcpy(_bank->_block[_channel]+1, _in + _number_Of_Lanes + (size_t)_lane*(n-1), (n-1)*sizeof(float));
+		}
+		_bank->_samples[_channel] = n;
+	}
+	_bank->_first = _slot->_first;
+	_bank->_count = _slot->_count;
+}
+
+/** Function to give a lane its block. Blocks are generated in order (the AR1 lanes carry their
+ *  state from one to the next), each one in the slot of the block two before, once every lane
+ *  still capturing has copied it. */
+void fetch_Sensor_Group(LHC_Sensor_Group *_group, unsigned int _lane, const LHC_Sensor_Model *_models, uint64_t _seed,
+		unsigned int _first, unsigned int _count, LHC_Sensor_Bank *_bank) {
+
+	unsigned int _index = _first/LHC_SENSOR_BLOCK;
+	LHC_Sensor_Slot* _slot = &_group->_slots[_index%2];
+
+	if(_count>LHC_SENSOR_BLOCK) _count = LHC_SENSOR_BLOCK;
+
+	pthread_mutex_lock(&_group->_mutex);
+	while(_slot->_index!=_index) {
+		if(_index==_group->_next && _slot->_readers==0) {
+			generate_Block(_models, _seed, _group->_lanes, _group->_number_Of_Lanes, _bank->_stride, _first, _count,
+					_slot->_samples, &_slot->_block[0][0], LHC_SENSOR_LANES*LHC_SENSOR_BLOCK);
+			_slot->_index = _index;
+			_slot->_first = _first;
+			_slot->_count = _count;
+			_slot->_readers = _group->_members;
+			_group->_next++;
+		}
+		else pthread_cond_wait(&_group->_copied, &_group->_mutex);
+	}
+
+	copy_Sensor_Slot(_slot, _group->_number_Of_Lanes, _lane, _bank);
+	_group->_last[_lane] = _index;
+	if(--_slot->_readers==0) pthread_cond_broadcast(&_group->_copied);
+	pthread_mutex_unlock(&_group->_mutex);
+}
+
+/** Function to take a lane out: the blocks it did not copy no longer wait for it */
+void leave_Sensor_Group(LHC_Sensor_Group *_group, unsigned int _lane) {
+
+	unsigned int s;
+
+	pthread_mutex_lock(&_group->_mutex);
+	for(s=0;s<2;s++) {
+		LHC_Sensor_Slot* _slot = &_group->_slots[s];
+
+		if(_slot->_index!=LHC_SENSOR_NO_TURN && _slot->_readers>0 &&
+				(_group->_last[_lane]==LHC_SENSOR_NO_TURN || _slot->_index>_group->_last[_lane])) _slot->_readers--;
+	}
+	_group->_members--;
+	pthread_cond_broadcast(&_group->_copied);
+	pthread_mutex_unlock(&_group->_mutex);
+}
@@ -0,0 +1,59 @@
+//==============================================================================//
+//  Filename: lhc_series.c														//
+//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+/* Local includes */
+#include "../include/lhc_series.h"
+
+#include <stdlib.h>
+
+const char* channel_Name(LHC_Channel _channel) {
+
+	static const char* _names[LHC_CHANNELS] = {
+		"particle_Radiation", "particle_Speed", "magnet_Current",
+		"helium_Temp", "helium_Pressure", "phase_RF"
+	};
+
+	return (_channel<LHC_CHANNELS) ? _names[_channel] : "unknown";
+}
+
+/** Function to allocate the series of a run */
+LHC_Series* create_Series(unsigned int _number_Of_Nodes, unsigned int _number_Of_Turns) {
+
+	LHC_Series* _series;
+	unsigned int i;
+
+	_series = ( LHC_Series* ) calloc( 1, sizeof( LHC_Series ) );
+	if(!_series) return NULL;
+	_series->_number_Of_Nodes = _number_Of_Nodes;
+	_series->_number_Of_Turns = _number_Of_Turns;
+	_series->_identifiers = ( int* ) calloc( _number_Of_Nodes, sizeof( int ) );
+	_series->_data = ( float* ) calloc( (size_t)_number_Of_Nodes*LHC_CHANNELS*_number_Of_Turns, sizeof( float ) );
+	if(!_series->_identifiers || !_series->_data) {
+		destroy_Series(_series);
+		return NULL;
+	}
+	for(i=0;i<_number_Of_Nodes;i++) _series->_identifiers[i] = i;
+
+	return _series;
+}
+
+int add_Beam_Series(LHC_Series *_series) {
+
+	if(!_series->_beam)
+		_series->_beam = ( float* ) calloc( (size_t)_series->_number_Of_Nodes*LHC_BEAM_PLANES*_series->_number_Of_Turns, sizeof( float ) );
+	return _series->_beam ? 0 : -1;
+}
+
+void destroy_Series(LHC_Series *_series) {
+
+	if(!_series) return;
+	free(_series->_identifiers);
+	free(_series->_data);
+	free(_series->_beam);
+	free(_series);
+}
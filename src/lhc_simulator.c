@@ -18,176 +18,973 @@
 #define TEV 1e12 						/* TeV. unit adapted to IS. */
 #define P_EXPECTED_SPEED 299792455.3 	/* Expected speed of the particle at the latest LHC Phase */
 
+#define PACING_SPIN 20000				/* Default spin before each paced deadline (ns). */
+#define PACING_LEAD 1000000				/* Paced mode starts 1ms after node 0 says so (ns). */
+
+#define IO_BUFFERS 32					/* Default buffers of the I/O engine. */
+#define IO_BUFFER_SIZE (256*1024)		/* Default size of each I/O buffer (bytes). */
+#define IO_BUFFER_MIN 4096				/* A buffer always holds several lines. */
+
+#define TRIGGER_WORKERS 2				/* Default worker threads of the trigger. */
+#define TRIGGER_BURSTS 8				/* Bursts in the pool of the trigger, per interaction point. */
+
+
+/*  SIMULATION FUNCTIONS  */
+/*~~~~~~~~~~~~~~~~~~~~~~~~*/
+/** Function to fill a configuration with the default values */
+void lhc_Sim_Default_Config(LHC_Sim_Config *_config) {
+
+	assert( _config );
+
+	memset(_config, 0, sizeof(LHC_Sim_Config));
+	_config->_number_Of_Nodes		= 16;
+	_config->_number_Of_Measures	= 1000;
+	_config->_capture_Mode			= LHC_CAPTURE_SEQUENTIAL;
+	_config->_seed					= 1;
+	default_Sensor_Models(_config->_sensor_Model);
+	_config->_countdown				= 0;
+	_config->_write_Files			= 1;
+	_config->_output_Prefix			= LHC_NODE_FILE_PREFIX;
+	_config->_verbose				= 1;
+	_config->_pacing_Spin			= PACING_SPIN;
+	_config->_pacing_Stats			= NULL;
+	_config->_io_Uring				= 1;
+	_config->_io_Buffers			= IO_BUFFERS;
+	_config->_io_Buffer_Size		= IO_BUFFER_SIZE;
+	default_Channel_Formats(_config->_channel_Format);
+	_config->_telemetry_Name		= NULL;
+	_config->_telemetry_Interval	= 1;
+	default_Trigger_Menu(&_config->_trigger_Menu);
+	_config->_trigger_Workers		= TRIGGER_WORKERS;
+	_config->_event_File			= LHC_EVENT_FILE;
+	default_Beam_Config(&_config->_beam);
+	_config->_beam_Prefix			= LHC_BEAM_FILE_PREFIX;
+}
 
-/** We provide information of the already existing global variables */
-extern pthread_mutex_t mutex;
-extern int turn;
-extern int _t_Global;
+/** Function to keep the first error of the simulation. Call it with the MUTEX on. */
+static void set_Error(LHC_Sim *_sim, int _error) {
+	if(_sim->_results._error==0) _sim->_results._error = _error;
+}
 
+/** Function to convert a duration in ns */
+static void ns_To_Timeval(struct timeval *_tv, int64_t _ns) {
+	_tv->tv_sec = _ns/1000000000LL;
+	_tv->tv_usec = (_ns%1000000000LL)/1000;
+}
 
-/*  NODE FUNCTIONS  */
-/*~~~~~~~~~~~~~~~~~~*/
-/** Function to create the _lhc_Node and to handle both multithreading and simulation */
-void create_Node(int *_node_Start) {
+/** Function to start the capture, once every initial node is ready (the optional countdown
+ *  comes first). Every node waiting at the barrier, and the interaction points, go on. Call
+ *  it with the MUTEX on. */
+static void start_Sim(LHC_Sim *_sim) {
 
-	char _name_Node_File[30]="LHC_Sim_ID_Node",_aux[7];
-	FILE 	*fp;
-	int		fd=0;
+	unsigned int _count;
 
-	/** Set the global MUTEX on */
-	pthread_mutex_lock(&mutex);
+	if(_sim->_config._verbose) printf("All the nodes are created.\n");
+	if(_sim->_config._countdown>0) {
+		pthread_mutex_unlock(&_sim->_mutex);
+		for(_count=_sim->_config._countdown;_count>0;_count--){
+			if(_sim->_config._verbose) printf("Starting simulation in %u...\n", _count);
+			sleep(1);
+		}
+		pthread_mutex_lock(&_sim->_mutex);
+	}
+	_sim->_start_Time = monotonic_Now();
+	_sim->_origin = _sim->_start_Time + PACING_LEAD;
+	__atomic_store_n(&_sim->_started, 1, __ATOMIC_RELEASE);
+	pthread_cond_broadcast(&_sim->_start);
+}
+
+/** Function to keep the instant of the earliest capture of the simulation */
+static void first_Capture(LHC_Sim *_sim) {
+
+	int64_t _now = monotonic_Now();
+	int64_t _first = __atomic_load_n(&_sim->_first_Capture, __ATOMIC_RELAXED);
+
+	while((_first==0 || _now<_first) &&
+			!__atomic_compare_exchange_n(&_sim->_first_Capture, &_first, _now, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
 
-	/** Check whether it the turn for the present node to initialize values (sequential disposition
-	 *  of NODES.) */
-	while(turn!= (*_node_Start-(floor(*_node_Start/10000))*10000)) {
-		pthread_mutex_unlock(&mutex);
-		pthread_mutex_lock(&mutex);;
+/** Function to know whether a node captures at revolution 'r' (sequential mode) */
+static int takes_Turn(const LHC_Node_Task *_task, unsigned int r) {
+	return _task->_first_Turn!=LHC_TURN_PENDING && _task->_first_Turn<=r &&
+			!__atomic_load_n(&_task->_retired, __ATOMIC_ACQUIRE);
+}
+
+/** Function to hand the turn to the next member of the ring during the capture (sequential
+ *  mode). Once the last member of a revolution is done, the ring moves to the next one and
+ *  the nodes added meanwhile join it. Call it with the MUTEX on. */
+static void pass_Ring(LHC_Sim *_sim, const LHC_Node_Task *_task) {
+
+	const LHC_Ring*	_ring;
+	unsigned int	r = _sim->_revolution, _next = LHC_NO_TURN, i;
+
+	enter_Epoch(&_sim->_epoch, _task->_identifier);
+	_ring = __atomic_load_n(&_sim->_ring, __ATOMIC_ACQUIRE);
+
+	/** Members met after this node in the current revolution... */
+	for(i=0;i<_ring->_number_Of_Members && _next==LHC_NO_TURN;i++) {
+		const LHC_Ring_Member* _member = &_ring->_members[i];
+
+		if((_member->_position > _task->_position ||
+				(_member->_position == _task->_position && _member->_identifier > _task->_identifier)) &&
+				takes_Turn(&_sim->_tasks[_member->_identifier], r)) _next = _member->_identifier;
 	}
 
-	/** Set environment variable */
-	int _number_Of_Nodes, i=0,j=0;
+	/** ...otherwise the revolution is over */
+	if(_next==LHC_NO_TURN && ++r < _sim->_config._number_Of_Measures) {
+		for(i=0;i<_ring->_number_Of_Members;i++) {
+			LHC_Node_Task* _member = &_sim->_tasks[_ring->_members[i]._identifier];
+			if(_member->_first_Turn==LHC_TURN_PENDING) _member->_first_Turn = r;
+		}
+		for(i=0;i<_ring->_number_Of_Members && _next==LHC_NO_TURN;i++)
+			if(takes_Turn(&_sim->_tasks[_ring->_members[i]._identifier], r)) _next = _ring->_members[i]._identifier;
+	}
+	exit_Epoch(&_sim->_epoch, _task->_identifier);
+
+	_sim->_turn = _next;
+	if(_next!=LHC_NO_TURN) {
+		__atomic_store_n(&_sim->_revolution, r, __ATOMIC_RELEASE);
+		pthread_cond_signal(&_sim->_tasks[_next]._cond);
+	} else {
+		/** No revolution left, or nobody left in the ring: the nodes still waiting stop */
+		__atomic_store_n(&_sim->_revolution, _sim->_config._number_Of_Measures, __ATOMIC_RELEASE);
+		for(i=0;i<_sim->_config._max_Nodes;i++) pthread_cond_signal(&_sim->_tasks[i]._cond);
+	}
+}
 
-	/** Create node */
-	LHC_Node* _lhc_Node;
+/** Function to wait for the turn of the node during the capture (sequential mode). Call it
+ *  with the MUTEX on. Returns 0 if the node must stop (aborted, removed or no revolution left). */
+static int wait_Ring(LHC_Sim *_sim, LHC_Node_Task *_task) {
+	while(_sim->_turn != _task->_identifier && !_sim->_abort && !__atomic_load_n(&_task->_retired, __ATOMIC_ACQUIRE) &&
+			_sim->_revolution < _sim->_config._number_Of_Measures)
+		pthread_cond_wait(&_task->_cond, &_sim->_mutex);
 
-	/** Calculate the number of existing nodes from the '_node_Start' variable.
-	 *  Notice each _node_Start has both the information of the total amount of
-	 *  nodes and the information regarding to the identifier of the present node:
-	 *  XX|XXXX   -  The first two 'X' provides information of the amount of nodes
-	 *  and the remaining 'XXXX' provides information of the identifier. */
-	_number_Of_Nodes  = floor(*_node_Start/10000);
+	return _sim->_turn == _task->_identifier && !_sim->_abort;
+}
 
-	/** Allocate memory for each struct LHC-Node*/
-	_lhc_Node = ( LHC_Node* ) malloc( sizeof( LHC_Node ) );
-	/** Initialize the _lhc_Node parameters */
-	_lhc_Node->_identifier=(*_node_Start-_number_Of_Nodes*10000);
-	_lhc_Node->_number_Of_Measures=1000;
-	_lhc_Node->_position = (26659/_number_Of_Nodes)*_lhc_Node->_identifier;
-	_lhc_Node->_cadence = (float)(26659/_number_Of_Nodes)/299792455.3;
-	/** Allocate information for the # of measures at each node (this may
-	 *  be a lot of information). */
-	_lhc_Node->_measures = ( Measure* ) calloc( _lhc_Node->_number_Of_Measures, sizeof( Measure ) );
-
-	printf("Done Creating node and allocating memory - LHC-Node: %d.\n", _lhc_Node->_identifier);
-
-	/** In case this is the last LHC_Node to be created, we set again the global
-	 *  variable 'turn' to 0. We can modify the variable without problems thanks
-	 *  to the 'mutex' lock we use. */
-	if(_lhc_Node->_identifier<_number_Of_Nodes-1) turn++;
-	else {
-		printf("All the nodes are created.\n");
-		turn=0;
+/** Function to know the next revolution of the furthest member of a ring (free mode) */
+static unsigned int furthest_Turn(const LHC_Sim *_sim, const LHC_Ring *_ring) {
+
+	unsigned int _furthest=0, _next, i;
+
+	for(i=0;i<_ring->_number_Of_Members;i++) {
+		_next = __atomic_load_n(&_sim->_tasks[_ring->_members[i]._identifier]._next_Turn, __ATOMIC_RELAXED);
+		if(_next > _furthest) _furthest = _next;
 	}
-	/** Set the global MUTEX off */
-	pthread_mutex_unlock(&mutex);
+	return _furthest;
+}
+
+/** Function to know the revolution running. Call it with '_ring_Mutex' on. */
+static unsigned int current_Revolution(LHC_Sim *_sim) {
 
-	/** You set the global MUTEX on */
-	pthread_mutex_lock(&mutex);
+	unsigned int _furthest;
+	int64_t _now;
 
-	/** The thread check whether it is his turn or not...  */
-	while(turn!= (*_node_Start-(floor(*_node_Start/10000))*10000)) {
-		pthread_mutex_unlock(&mutex);
-		pthread_mutex_lock(&mutex);
+	if(!__atomic_load_n(&_sim->_started, __ATOMIC_ACQUIRE)) return 0;
+
+	switch(_sim->_config._capture_Mode) {
+	case LHC_CAPTURE_PACED:
+		_now = monotonic_Now();
+		if(_now < _sim->_origin) return 0;
+		return (unsigned int)((_now - _sim->_origin)/(1e9*LHC_PERIMETER/P_EXPECTED_SPEED));
+	case LHC_CAPTURE_FREE:
+		_furthest = furthest_Turn(_sim, _sim->_ring);
+		return _furthest ? _furthest-1 : 0;
+	default:
+		return __atomic_load_n(&_sim->_revolution, __ATOMIC_ACQUIRE);
 	}
+}
+
+/** Function to know the first revolution of a node in free and paced modes: 0 for the
+ *  initial nodes, the one after the revolution running when they were added for the others
+ *  (in free mode, the furthest node may be further by the time the thread starts). */
+static unsigned int join_Turn(LHC_Sim *_sim, const LHC_Node_Task *_task) {
 
-	/** Set time variables to start a new simulation... */
-	struct timespec _t_Start,_t_End;
-	_t_Start.tv_sec = 0;
-	_t_Start.tv_nsec = 0;
+	unsigned int _first = _task->_added_Turn+1;
+	unsigned int r;
 
-	_t_Global = (int)(26659/_number_Of_Nodes)/P_EXPECTED_SPEED;
+	if(_task->_identifier < _sim->_config._number_Of_Nodes) return 0;
+	if(_sim->_config._capture_Mode == LHC_CAPTURE_PACED) return _first;
+
+	enter_Epoch(&_sim->_epoch, _task->_identifier);
+	r = furthest_Turn(_sim, __atomic_load_n(&_sim->_ring, __ATOMIC_ACQUIRE));
+	exit_Epoch(&_sim->_epoch, _task->_identifier);
+
+	return (r > _first) ? r : _first;
+}
 
-	/** We calculate the 'expected' times it takes to the particles to reach the NODE again
-	 *  (after going all along the LHC_Perimeter - 26659 m).
-	 *  However, there are several threads that are running concurrently in the machine, each of
-	 *  them trying to capture a measure. To control their correct timing at "sampling", we will
-	 *  ask each node to "sleep" for a determinate time so they will let other threads 'lock'
-	 *  the process until they capture  */
-	_t_End.tv_sec=0;
-	_t_End.tv_nsec=26659/P_EXPECTED_SPEED/10;
+/** Function to publish a new ring. The old one is freed once no node reads it any more.
+ *  Call it with '_ring_Mutex' on. */
+static void publish_Ring(LHC_Sim *_sim, LHC_Ring *_ring) {
 
-	/** Once all nodes are created and memory is allocated for all of them, the initial node
-	 * (with identifier '0') start the simulation.
-	 */
-	if(turn==0){
-		printf("Starting simulation in 3...\n"); sleep(1);
-		printf("2...\n"); sleep(1);
-		printf("1..\n"); sleep(1);
+	LHC_Ring* _old = _sim->_ring;
+
+	__atomic_store_n(&_sim->_ring, _ring, __ATOMIC_SEQ_CST);
+	retire_Epoch(&_sim->_epoch, _old);
+	collect_Epoch(&_sim->_epoch);
+}
+
+/** Function to free the context of a simulation (the node threads are over) */
+static void free_Sim(LHC_Sim *_sim) {
+
+	unsigned int i;
+
+	destroy_Trigger(_sim->_trigger, NULL);
+	destroy_Tracker(_sim->_tracker);
+	destroy_Lattice(_sim->_lattice);
+	destroy_IO_Engine(_sim->_io);
+	destroy_Telemetry(_sim->_telemetry);
+	for(i=0;i<_sim->_number_Of_Sensor_Groups;i++) destroy_Sensor_Group(&_sim->_sensor_Groups[i]);
+	free(_sim->_sensor_Groups);
+	destroy_Epoch(&_sim->_epoch);
+	free(_sim->_ring);
+	for(i=0;i<_sim->_config._max_Nodes;i++) pthread_cond_destroy(&_sim->_tasks[i]._cond);
+	pthread_cond_destroy(&_sim->_start);
+	pthread_mutex_destroy(&_sim->_ring_Mutex);
+	pthread_mutex_destroy(&_sim->_mutex);
+	free(_sim->_ips);
+	free(_sim->_tasks);
+	free(_sim);
+}
+
+/** Function to cancel a simulation being started: the threads already created give up and
+ *  are waited for, then everything is freed. */
+static void abort_Sim(LHC_Sim *_sim, int _error) {
+
+	unsigned int i;
+
+	pthread_mutex_lock(&_sim->_mutex);
+	_sim->_abort = 1;
+	for(i=0;i<_sim->_number_Of_Tasks;i++) pthread_cond_signal(&_sim->_tasks[i]._cond);
+	pthread_cond_broadcast(&_sim->_start);
+	pthread_mutex_unlock(&_sim->_mutex);
+	for(i=0;i<_sim->_number_Of_Tasks;i++) pthread_join(_sim->_tasks[i]._thread, NULL);
+	for(i=0;i<_sim->_number_Of_IPs;i++) pthread_join(_sim->_ips[i]._thread, NULL);
+	free_Sim(_sim);
+	errno = _error;
+}
+
+static void* run_Interaction_Point(void *);
+
+/** Function to run a whole simulation. Every node gets its own thread, and all the
+ *  state is kept in a context owned by this call. */
+int lhc_Sim_Run(const LHC_Sim_Config *_config, LHC_Sim_Results *_results) {
+
+	LHC_Sim* _sim;
+
+	if(!_results) {
+		errno = EINVAL;
+		return -1;
 	}
+	_sim = lhc_Sim_Start(_config);
+	if(!_sim) return -1;
 
-	/** In order to achieve synchronization between threads...*/
-	while(i<_lhc_Node->_number_Of_Measures) {
+	return lhc_Sim_Wait(_sim, _results);
+}
 
-		/** Until we don't reach 'run-time' we let the node sleep 1/10 of the total running time */
-		while(j<10 && turn!= (*_node_Start-(floor(*_node_Start/10000))*10000)){
-			if(j<10) if(nanosleep(&_t_Start,&_t_End)<0) printf("Nanosleep failed!\n");
-			pthread_mutex_unlock(&mutex);
-			pthread_mutex_lock(&mutex);
-			j++;
+/** Function to start a simulation: the initial nodes are created and the function returns
+ *  while they run. */
+LHC_Sim* lhc_Sim_Start(const LHC_Sim_Config *_config) {
+
+	LHC_Sim* _sim;
+	LHC_Ring* _ring;
+	unsigned int i, _slots, _created=0;
+	int _error=0;
+
+	if(!_config || _config->_number_Of_Nodes==0 || _config->_number_Of_Measures==0 ||
+			(_config->_max_Nodes && _config->_max_Nodes<_config->_number_Of_Nodes) ||
+			_config->_number_Of_Interaction_Points>LHC_IP_MAX ||
+			(_config->_number_Of_Interaction_Points && !_config->_interaction_Points) ||
+			(_config->_series && (_config->_series->_number_Of_Nodes!=_config->_number_Of_Nodes ||
+					_config->_series->_number_Of_Turns!=_config->_number_Of_Measures))) {
+		errno = EINVAL;
+		return NULL;
+	}
+	_slots = _config->_max_Nodes ? _config->_max_Nodes : _config->_number_Of_Nodes;
+
+	/** Allocate the simulation context */
+	_sim = ( LHC_Sim* ) calloc( 1, sizeof( LHC_Sim ) );
+	if(!_sim) return NULL;
+	gettimeofday(&_sim->_begin, NULL);
+	_sim->_begin_Time = monotonic_Now();
+	_sim->_config = *_config;
+	_sim->_config._max_Nodes = _slots;
+	if(!_sim->_config._output_Prefix) _sim->_config._output_Prefix = LHC_NODE_FILE_PREFIX;
+	if(!_sim->_config._event_File) _sim->_config._event_File = LHC_EVENT_FILE;
+	if(!_sim->_config._beam_Prefix) _sim->_config._beam_Prefix = LHC_BEAM_FILE_PREFIX;
+	if(!_sim->_config._trigger_Workers) _sim->_config._trigger_Workers = TRIGGER_WORKERS;
+	clear_Pacing_Stats(&_sim->_results._pacing);
+	clear_Trigger_Stats(&_sim->_results._trigger);
+
+	_sim->_tasks = ( LHC_Node_Task* ) calloc( _slots, sizeof( LHC_Node_Task ) );
+	if(!_sim->_tasks) {
+		free(_sim);
+		return NULL;
+	}
+	if((_error = pthread_mutex_init(&_sim->_mutex, NULL))==0 && (_error = pthread_mutex_init(&_sim->_ring_Mutex, NULL))!=0)
+		pthread_mutex_destroy(&_sim->_mutex);
+	if(_error!=0) {
+		free(_sim->_tasks);
+		free(_sim);
+		errno = _error;
+		return NULL;
+	}
+	pthread_cond_init(&_sim->_start, NULL);
+	for(i=0;i<_slots;i++){
+		_sim->_tasks[i]._sim = _sim;
+		_sim->_tasks[i]._identifier = i;
+		pthread_cond_init(&_sim->_tasks[i]._cond, NULL);
+	}
+
+	/** The ring starts with the initial nodes, evenly spread */
+	_sim->_ring = create_Ring();
+	if(!_sim->_ring || init_Epoch(&_sim->_epoch, _slots)!=0) {
+		free_Sim(_sim);
+		errno = ENOMEM;
+		return NULL;
+	}
+	for(i=0;i<_config->_number_Of_Nodes;i++){
+		_sim->_tasks[i]._position = (LHC_PERIMETER/_config->_number_Of_Nodes)*i;
+		_ring = insert_Ring_Member(_sim->_ring, i, _sim->_tasks[i]._position);
+		if(!_ring) {
+			free_Sim(_sim);
+			errno = ENOMEM;
+			return NULL;
 		}
-		j=0;
-		/** Perform capture of Measures */
-		_lhc_Node->_measures[i]._identifier=_lhc_Node->_identifier;
-		_lhc_Node->_measures[i]._position=_lhc_Node->_position;
+		free(_sim->_ring);
+		_sim->_ring = _ring;
+	}
+
+	/** The initial nodes generate their sensors by groups */
+	_sim->_sensor_Groups = ( LHC_Sensor_Group* ) calloc( (_config->_number_Of_Nodes + LHC_SENSOR_LANES-1)/LHC_SENSOR_LANES, sizeof( LHC_Sensor_Group ) );
+	if(!_sim->_sensor_Groups) {
+		free_Sim(_sim);
+		errno = ENOMEM;
+		return NULL;
+	}
+	for(i=0;i<_config->_number_Of_Nodes;i+=LHC_SENSOR_LANES){
+		LHC_Sensor_Group* _group = &_sim->_sensor_Groups[i/LHC_SENSOR_LANES];
+		unsigned int _lane, _lanes = (_config->_number_Of_Nodes-i < LHC_SENSOR_LANES) ? _config->_number_Of_Nodes-i : LHC_SENSOR_LANES;
+
+		if((_error = init_Sensor_Group(_group, _lanes))!=0) {
+			free_Sim(_sim);
+			errno = _error;
+			return NULL;
+		}
+		_sim->_number_Of_Sensor_Groups++;
+		for(_lane=0;_lane<_lanes;_lane++)
+			init_Sensor_Lane(&_group->_lanes[_lane], _config->_sensor_Model, i+_lane, _sim->_tasks[i+_lane]._position/LHC_PERIMETER);
+	}
+
+	/** One single engine writes the files of all the nodes (and the events: every worker of
+	 *  the trigger keeps one buffer of its own) */
+	if(_config->_write_Files) {
+		_sim->_io = create_IO_Engine((_config->_io_Buffers ? _config->_io_Buffers : IO_BUFFERS) +
+				(_config->_number_Of_Interaction_Points ? _sim->_config._trigger_Workers : 0),
+				_config->_io_Buffer_Size>IO_BUFFER_MIN ? _config->_io_Buffer_Size : IO_BUFFER_MIN,
+				_config->_io_Uring);
+		if(!_sim->_io) {
+			_error = errno;
+			free_Sim(_sim);
+			errno = _error;
+			return NULL;
+		}
+		_sim->_results._io_Uring = uses_IO_Uring(_sim->_io);
+	}
+
+	/** Live telemetry: one slot per node */
+	if(_config->_telemetry_Name) {
+		_sim->_telemetry = create_Telemetry(_config->_telemetry_Name, _slots, _config->_number_Of_Measures);
+		if(!_sim->_telemetry) {
+			_error = errno;
+			free_Sim(_sim);
+			errno = _error;
+			return NULL;
+		}
+	}
+
+	/** Beam tracking: the initial nodes are the monitors, and the tracking runs ahead of them */
+	if(_config->_beam._particles) {
+		LHC_Twiss _twiss_X, _twiss_Y;
+		float* _positions = ( float* ) malloc( _config->_number_Of_Nodes*sizeof( float ) );
+
+		_sim->_lattice = _positions ? create_FODO_Lattice(LHC_PERIMETER, _config->_beam._cells, _config->_beam._tune_X, _config->_beam._tune_Y) : NULL;
+		if(_sim->_lattice && lattice_Twiss(_sim->_lattice, 0.0, &_twiss_X, &_twiss_Y)==0) {
+			_sim->_results._tune_X = _twiss_X._tune;
+			_sim->_results._tune_Y = _twiss_Y._tune;
+			for(i=0;i<_config->_number_Of_Nodes;i++) _positions[i] = _sim->_tasks[i]._position;
+			_sim->_tracker = create_Tracker(_sim->_lattice, &_config->_beam, _positions, _config->_number_Of_Nodes,
+					_config->_number_Of_Measures, _config->_seed);
+		}
+		_error = errno;
+		free(_positions);
+		if(!_sim->_tracker) {
+			free_Sim(_sim);
+			errno = _error;
+			return NULL;
+		}
+	}
+
+	/** Interaction points: their threads wait for node 0 to start the simulation */
+	if(_config->_number_Of_Interaction_Points) {
+		_sim->_trigger = create_Trigger(&_sim->_config._trigger_Menu, _sim->_config._trigger_Workers,
+				TRIGGER_BURSTS*_config->_number_Of_Interaction_Points, _sim->_io, _sim->_config._event_File);
+		if(_sim->_trigger) _sim->_ips = ( LHC_IP_Task* ) calloc( _config->_number_Of_Interaction_Points, sizeof( LHC_IP_Task ) );
+		if(!_sim->_ips) {
+			_error = errno;
+			free_Sim(_sim);
+			errno = _error;
+			return NULL;
+		}
+		for(i=0;i<_config->_number_Of_Interaction_Points;i++){
+			_sim->_ips[i]._sim = _sim;
+			_sim->_ips[i]._index = i;
+			_sim->_ips[i]._point = _config->_interaction_Points[i];
+			_error = pthread_create(&_sim->_ips[i]._thread, NULL, run_Interaction_Point, &_sim->_ips[i]);
+			if(_error!=0) {
+				abort_Sim(_sim, _error);
+				return NULL;
+			}
+			_sim->_number_Of_IPs++;
+		}
+	}
+
+	/** We start the multithreading, where each thread corresponds to each node. */
+	for(i=0;i<_config->_number_Of_Nodes;i++){
+		_error = pthread_create(&_sim->_tasks[i]._thread, NULL, create_Node, &_sim->_tasks[i]);
+		if(_error!=0) break;
+		_created++;
+	}
+	_sim->_number_Of_Tasks = _created;
+
+	/** In case a thread could not be created, the ring is broken: the rest of
+	 *  the nodes are told to give up. */
+	if(_error!=0) {
+		abort_Sim(_sim, _error);
+		return NULL;
+	}
+
+	return _sim;
+}
+
+/** Function to add a node while the simulation runs. Only '_ring_Mutex' is taken: the nodes
+ *  capturing are never stopped. */
+int lhc_Sim_Add_Node(LHC_Sim *_sim, float _position) {
+
+	LHC_Node_Task*	_task;
+	LHC_Ring*		_ring;
+	int				_error=0;
+
+	if(!_sim || !(_position>=0 && _position<LHC_PERIMETER)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	pthread_mutex_lock(&_sim->_ring_Mutex);
+	if(_sim->_closed) _error = EINVAL;
+	else if(_sim->_number_Of_Tasks >= _sim->_config._max_Nodes) _error = ENOSPC;
+	else if(current_Revolution(_sim)+1 >= _sim->_config._number_Of_Measures) _error = ERANGE;
+	if(_error!=0) {
+		pthread_mutex_unlock(&_sim->_ring_Mutex);
+		errno = _error;
+		return -1;
+	}
+
+	_task = &_sim->_tasks[_sim->_number_Of_Tasks];
+	_task->_position = _position;
+	_task->_added_Turn = current_Revolution(_sim);
+	_task->_first_Turn = LHC_TURN_PENDING;
+	_task->_next_Turn = 0;
+	_task->_retired = 0;
+
+	/** The thread prepares the node, the new ring makes it visible to the others */
+	_ring = insert_Ring_Member(_sim->_ring, _task->_identifier, _position);
+	if(!_ring) _error = ENOMEM;
+	else if((_error = pthread_create(&_task->_thread, NULL, create_Node, _task))!=0) free(_ring);
+	else {
+		_sim->_number_Of_Tasks++;
+		_sim->_results._nodes_Added++;
+		publish_Ring(_sim, _ring);
+	}
+	pthread_mutex_unlock(&_sim->_ring_Mutex);
+
+	if(_error!=0) {
+		errno = _error;
+		return -1;
+	}
+	return (int)_task->_identifier;
+}
+
+/** Function to remove a node while the simulation runs */
+int lhc_Sim_Remove_Node(LHC_Sim *_sim, unsigned int _identifier) {
+
+	LHC_Ring* _ring;
+
+	if(!_sim) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	pthread_mutex_lock(&_sim->_ring_Mutex);
+	_ring = remove_Ring_Member(_sim->_ring, _identifier);
+	if(!_ring) {
+		pthread_mutex_unlock(&_sim->_ring_Mutex);
+		return -1;
+	}
+	__atomic_store_n(&_sim->_tasks[_identifier]._retired, 1, __ATOMIC_RELEASE);
+	_sim->_results._nodes_Removed++;
+	publish_Ring(_sim, _ring);
+	pthread_mutex_unlock(&_sim->_ring_Mutex);
+
+	/** In sequential mode the node may be waiting for a turn that will never come */
+	if(_sim->_config._capture_Mode == LHC_CAPTURE_SEQUENTIAL) {
+		pthread_mutex_lock(&_sim->_mutex);
+		pthread_cond_signal(&_sim->_tasks[_identifier]._cond);
+		pthread_mutex_unlock(&_sim->_mutex);
+	}
+	return 0;
+}
+
+unsigned int lhc_Sim_Revolution(LHC_Sim *_sim) {
 
-		/** All measures are going to be comprised between 0 and 1 to make it easier to work with them*/
-		_lhc_Node->_measures[i]._particle_Radiation=(float)rand()/RAND_MAX;
-		_lhc_Node->_measures[i]._particle_Speed=(float)rand()/RAND_MAX;
-		_lhc_Node->_measures[i]._magnet_Current=(float)rand()/RAND_MAX;
-		_lhc_Node->_measures[i]._helium_Temp=(float)rand()/RAND_MAX;
-		_lhc_Node->_measures[i]._helium_Pressure =(float)rand()/RAND_MAX;
-		_lhc_Node->_measures[i]._phase_RF =(float)rand()/RAND_MAX;
+	unsigned int r;
 
-		/* Check which is the next node in the sequence */
-		if(_lhc_Node->_identifier<=_number_Of_Nodes-1) {
-				turn++;
-		} else turn=0;
+	pthread_mutex_lock(&_sim->_ring_Mutex);
+	r = current_Revolution(_sim);
+	pthread_mutex_unlock(&_sim->_ring_Mutex);
+
+	return r;
+}
 
-		i++; /** Increment the number of measures */
-		pthread_mutex_unlock(&mutex);
-		pthread_mutex_lock(&mutex);
+/** Function to wait for all the nodes (the initial and the added ones) */
+int lhc_Sim_Wait(LHC_Sim *_sim, LHC_Sim_Results *_results) {
+
+	struct timeval _tvEnd;
+	unsigned int i, _tasks;
+
+	if(!_sim || !_results) {
+		errno = EINVAL;
+		return -1;
 	}
 
+	/** From now on no node is added */
+	pthread_mutex_lock(&_sim->_ring_Mutex);
+	_sim->_closed = 1;
+	_tasks = _sim->_number_Of_Tasks;
+	pthread_mutex_unlock(&_sim->_ring_Mutex);
+
+	for(i=0;i<_tasks;i++) pthread_join(_sim->_tasks[i]._thread, NULL);
+	for(i=0;i<_sim->_number_Of_IPs;i++) pthread_join(_sim->_ips[i]._thread, NULL);
+
+	/** The trigger decides the bursts left and closes the file of events */
+	if(_sim->_trigger) {
+		int _error = destroy_Trigger(_sim->_trigger, &_sim->_results._trigger);
+		_sim->_trigger = NULL;
+		if(_error!=0) set_Error(_sim, _error);
+	}
+
+	/** The beam is tracked until the last revolution, even if every node left before */
+	if(_sim->_tracker && wait_Tracker(_sim->_tracker, _sim->_config._number_Of_Measures-1, 0))
+		ns_To_Timeval(&_sim->_results._tracking, _sim->_tracker->_end - _sim->_tracker->_begin);
+
+	/** Every file is closed by its node, so the engine has nothing left to write */
+	destroy_IO_Engine(_sim->_io);
+	_sim->_io = NULL;
+
+	gettimeofday(&_tvEnd, NULL);
+	time_Difference(&_sim->_results._elapsed, &_tvEnd, &_sim->_begin);
+	if(_sim->_started) ns_To_Timeval(&_sim->_results._startup, _sim->_start_Time - _sim->_begin_Time);
+	if(_sim->_first_Capture) ns_To_Timeval(&_sim->_results._first_Capture, _sim->_first_Capture - _sim->_begin_Time);
+	_sim->_results._number_Of_Nodes = _tasks;
+	*_results = _sim->_results;
+
+	/** We destroy the context of the simulation */
+	free_Sim(_sim);
+
+	if(_results->_error!=0) {
+		errno = _results->_error;
+		return -1;
+	}
+	return 0;
+}
+
+
+/*  INTERACTION POINT FUNCTIONS  */
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+/** Function to produce the collisions of an interaction point, one burst per revolution,
+ *  and hand them to the trigger. In paced mode the bunches cross when the particle reaches
+ *  the point; otherwise the only limit is the pool of bursts of the trigger. */
+static void* run_Interaction_Point(void *_arg) {
+
+	LHC_IP_Task*	_task = ( LHC_IP_Task* ) _arg;
+	LHC_Sim*		_sim = _task->_sim;
+	LHC_Sim_Config*	_config = &_sim->_config;
+	int				_paced = (_config->_capture_Mode == LHC_CAPTURE_PACED);
+	LHC_Pacer		_pacer;
+	LHC_Burst*		_burst;
+	unsigned int	r;
+
+	pthread_mutex_lock(&_sim->_mutex);
+	while(!_sim->_started && !_sim->_abort) pthread_cond_wait(&_sim->_start, &_sim->_mutex);
+	if(_sim->_abort) {
+		pthread_mutex_unlock(&_sim->_mutex);
+		return NULL;
+	}
+	pthread_mutex_unlock(&_sim->_mutex);
+
+	if(_paced) init_Pacer(&_pacer, _sim->_origin, 1e9*LHC_PERIMETER/P_EXPECTED_SPEED,
+			1e9*_task->_point._position/P_EXPECTED_SPEED, _config->_pacing_Spin);
+
+	for(r=0;r<_config->_number_Of_Measures;r++) {
+		if(_paced) wait_Pacer(&_pacer, r);
+		_burst = get_Trigger_Burst(_sim->_trigger);
+		generate_Collisions(&_task->_point, _task->_index, _config->_seed, r, _burst);
+		_burst->_time = monotonic_Now();
+		submit_Trigger_Burst(_sim->_trigger, _burst);
+	}
+
+	return NULL;
+}
+
 
-	/** File writing*/
+/*  NODE FUNCTIONS  */
+/*~~~~~~~~~~~~~~~~~~*/
+/** Function to capture the measure of revolution 'i' at a node. The sensors are generated
+ *  by blocks of turns: most captures only read the current block. A channel sampled less
+ *  often is neither generated nor captured on the revolutions it is not due. */
+static void capture_Measure(LHC_Node *_lhc_Node, unsigned int i, LHC_Sensor_Bank *_bank, const LHC_Sim_Config *_config) {
+
+	unsigned int	_channel;
+
+	if(i < _bank->_first || i >= _bank->_first+_bank->_count)
+		fill_Sensor_Bank(_bank, _config->_sensor_Model, _config->_seed, i, _config->_number_Of_Measures-i);
+
+	/** Perform capture of Measures (stored with the precision of each channel) */
+	for(_channel=0;_channel<LHC_CHANNELS;_channel++)
+		if(channel_Due(_lhc_Node, _channel, i - _lhc_Node->_first_Turn))
+			encode_Channel(_lhc_Node, _channel, i - _lhc_Node->_first_Turn, _bank->_block[_channel][sensor_Slot(_bank, _channel, i)]);
+}
+
+/** Function to copy every channel of a node into the series of the run (the series only
+ *  has rows for the initial nodes) */
+static void copy_Series(LHC_Series *_series, const LHC_Node *_lhc_Node) {
 
-	/** Select the proper name for the file...*/
-	sprintf(_aux,"%d",*_node_Start);
-	strcat(_name_Node_File,_aux);
-	strcat(_name_Node_File,".txt");
+	unsigned int _channel, i;
 
-	fp = fopen(&_name_Node_File,"wb"); /** Open for writing */
-	if (!fp) printf("Not able to open file %s for writing...\n",_name_Node_File );
+	if((unsigned int)_lhc_Node->_identifier >= _series->_number_Of_Nodes) return;
+	_series->_identifiers[_lhc_Node->_identifier] = _lhc_Node->_identifier;
+	for(_channel=0;_channel<LHC_CHANNELS;_channel++)
+		decode_Channel(_lhc_Node, _channel, 0, _lhc_Node->_number_Of_Measures,
+				SERIES_ROW(_series, _lhc_Node->_identifier, _channel) + _lhc_Node->_first_Turn);
 
-	/** Writing all samples collected at each node...*/
+	/** The beam it saw, when the series keeps it */
+	if(_series->_beam && _lhc_Node->_beam) {
+		float* _x = BEAM_ROW(_series, _lhc_Node->_identifier, 0) + _lhc_Node->_first_Turn;
+		float* _y = BEAM_ROW(_series, _lhc_Node->_identifier, 1) + _lhc_Node->_first_Turn;
+
+		for(i=0;i<_lhc_Node->_number_Of_Measures;i++) {
+			_x[i] = _lhc_Node->_beam[i]._mean_X;
+			_y[i] = _lhc_Node->_beam[i]._mean_Y;
+		}
+	}
+}
+
+/** Function to write all samples collected at a node. The lines are formatted into the
+ *  buffers of the I/O engine, which writes them in the background. Returns 0 on success. */
+static int write_Node(const LHC_Sim *_sim, const LHC_Node *_lhc_Node) {
+
+	char 			_name_Node_File[512];
+	LHC_IO_Engine*	_io = _sim->_io;
+	LHC_IO_File*	_file;
+	LHC_IO_Buffer*	_buffer;
+	Measure			_measure;
+	unsigned int 	i;
+
+	/** Select the proper name for the file: the identifier is preceded by the
+	 *  amount of nodes (XX|XXXX) as it has always been. */
+	snprintf(_name_Node_File, sizeof(_name_Node_File), "%s%u.txt", _sim->_config._output_Prefix,
+			_sim->_config._number_Of_Nodes*10000+_lhc_Node->_identifier);
+
+	_file = open_IO_File(_io, _name_Node_File); /** Open for writing */
+	if (!_file) {
+		int _error = errno;
+		fprintf(stderr, "Not able to open file %s for writing...\n",_name_Node_File );
+		return _error;
+	}
+
+	/** Writing all samples collected at each node... Every buffer is filled with as many
+	 *  lines as fit, and written with one single write by the engine. */
+	_buffer = get_IO_Buffer(_io);
 	for(i=0;i<_lhc_Node->_number_Of_Measures;i++){
-		fprintf(fp,"%d:%d;%f;%f;%f;%f;%f;%f;%f.\n",
-				i,
-				_lhc_Node->_measures[i]._identifier,
-				_lhc_Node->_measures[i]._position,
-				_lhc_Node->_measures[i]._particle_Radiation,
-				_lhc_Node->_measures[i]._particle_Speed,
-				_lhc_Node->_measures[i]._magnet_Current,
-				_lhc_Node->_measures[i]._helium_Temp,
-				_lhc_Node->_measures[i]._helium_Pressure,
-				_lhc_Node->_measures[i]._phase_RF);
+		if(_buffer->_size - _buffer->_length < LHC_FORMAT_LINE_MAX) {
+			submit_IO_Buffer(_io, _file, _buffer);
+			_buffer = get_IO_Buffer(_io);
+		}
+		decode_Measure(_lhc_Node, i, &_measure);
+		_buffer->_length += format_Measure_Line(_buffer->_data + _buffer->_length, _lhc_Node->_first_Turn+i, &_measure);
 	}
+	submit_IO_Buffer(_io, _file, _buffer);
+
+	/** Close file (once the engine has written all of it) */
+	return close_IO_File(_io, _file);
+}
+
+/** Function to write the line of the beam seen at a measure: "i:id;mean_x;mean_y;sigma_x;sigma_y." */
+static size_t format_Beam_Line(char *_line, unsigned int i, int _identifier, const LHC_Beam_Position *_beam) {
+
+	char* p = _line;
 
-	/** Close file */
-	fclose(fp);
+	p += format_Int(p, (int)i);					*p++ = ':';
+	p += format_Int(p, _identifier);			*p++ = ';';
+	p += format_Float(p, _beam->_mean_X);		*p++ = ';';
+	p += format_Float(p, _beam->_mean_Y);		*p++ = ';';
+	p += format_Float(p, _beam->_sigma_X);		*p++ = ';';
+	p += format_Float(p, _beam->_sigma_Y);		*p++ = '.';
+	*p++ = '\n';
 
-	/** Destroy all Nodes*/
-	if(_lhc_Node->_identifier<=_number_Of_Nodes-1) {
-		turn++;
-		destroy_Node(_lhc_Node);
-	}	else {
-			printf("All the nodes have been destroyed.\n");
+	return (size_t)(p - _line);
+}
+
+/** Function to write the beam seen by a node, named as its node file. Returns 0 on success. */
+static int write_Beam(const LHC_Sim *_sim, const LHC_Node *_lhc_Node) {
+
+	char 			_name_Beam_File[512];
+	LHC_IO_Engine*	_io = _sim->_io;
+	LHC_IO_File*	_file;
+	LHC_IO_Buffer*	_buffer;
+	unsigned int 	i;
+
+	snprintf(_name_Beam_File, sizeof(_name_Beam_File), "%s%u.txt", _sim->_config._beam_Prefix,
+			_sim->_config._number_Of_Nodes*10000+_lhc_Node->_identifier);
+
+	_file = open_IO_File(_io, _name_Beam_File);
+	if (!_file) {
+		int _error = errno;
+		fprintf(stderr, "Not able to open file %s for writing...\n",_name_Beam_File );
+		return _error;
 	}
-	pthread_mutex_unlock(&mutex);
+
+	_buffer = get_IO_Buffer(_io);
+	for(i=0;i<_lhc_Node->_number_Of_Measures;i++){
+		if(_buffer->_size - _buffer->_length < LHC_FORMAT_LINE_MAX) {
+			submit_IO_Buffer(_io, _file, _buffer);
+			_buffer = get_IO_Buffer(_io);
+		}
+		_buffer->_length += format_Beam_Line(_buffer->_data + _buffer->_length, _lhc_Node->_first_Turn+i,
+				_lhc_Node->_identifier, &_lhc_Node->_beam[i]);
+	}
+	submit_IO_Buffer(_io, _file, _buffer);
+
+	return close_IO_File(_io, _file);
+}
+
+/** Function to allocate a node and its measures (NULL if there is no memory). A node added
+ *  while the simulation runs only needs room for the revolutions left. */
+static LHC_Node* allocate_Node(const LHC_Sim *_sim, const LHC_Node_Task *_task) {
+
+	const LHC_Sim_Config* _config = &_sim->_config;
+
+	/** Allocate memory for each struct LHC-Node*/
+	LHC_Node* _lhc_Node = ( LHC_Node* ) malloc( sizeof( LHC_Node ) );
+	if(_lhc_Node) {
+		/** Initialize the _lhc_Node parameters */
+		_lhc_Node->_identifier=_task->_identifier;
+		_lhc_Node->_number_Of_Measures=_config->_number_Of_Measures - _task->_added_Turn;
+		_lhc_Node->_first_Turn = 0;
+		_lhc_Node->_position = _task->_position;
+		_lhc_Node->_cadence = (float)(LHC_PERIMETER/P_EXPECTED_SPEED);
+		_lhc_Node->_beam = NULL;
+		/** Allocate information for the # of measures at each node (this may
+		 *  be a lot of information, so each channel only takes the precision it needs,
+		 *  and the slow ones only keep the samples they need). */
+		if(allocate_Channels(_lhc_Node, _config->_channel_Format)!=0) {
+			free(_lhc_Node);
+			_lhc_Node = NULL;
+		}
+		/** The beam it sees, when it is tracked */
+		else if(_sim->_tracker) {
+			_lhc_Node->_beam = ( LHC_Beam_Position* ) calloc( _lhc_Node->_number_Of_Measures, sizeof( LHC_Beam_Position ) );
+			if(!_lhc_Node->_beam) {
+				free_Channels(_lhc_Node);
+				free(_lhc_Node);
+				_lhc_Node = NULL;
+			}
+		}
+	}
+	return _lhc_Node;
+}
+
+/** Function to create the _lhc_Node and to handle both multithreading and simulation */
+void* create_Node(void *_arg) {
+
+	LHC_Node_Task* 	_task = ( LHC_Node_Task* ) _arg;
+	LHC_Sim* 		_sim = _task->_sim;
+	LHC_Sim_Config*	_config = &_sim->_config;
+	unsigned int	_number_Of_Nodes = _config->_number_Of_Nodes, i=0, _first=0, _captured=0, _channel;
+	int				_sequential = (_config->_capture_Mode == LHC_CAPTURE_SEQUENTIAL);
+	int				_paced = (_config->_capture_Mode == LHC_CAPTURE_PACED);
+	int				_added = (_task->_identifier >= _number_Of_Nodes);
+	int				_error=0;
+	LHC_Pacer		_pacer;
+	LHC_Sensor_Bank	_bank;
+	LHC_Sensor_Group* _group = _added ? NULL : &_sim->_sensor_Groups[_task->_identifier/LHC_SENSOR_LANES];
+	unsigned int	_lane = _task->_identifier%LHC_SENSOR_LANES;
+	LHC_Telemetry_Snapshot _snapshot;
+	Measure			_measure;
+	unsigned int	_interval = _config->_telemetry_Interval ? _config->_telemetry_Interval : 1;
+	unsigned int	_monitor = _sim->_tracker ? tracker_Monitor(_sim->_tracker, _task->_position) : 0;
+
+	/** Create node */
+	LHC_Node* _lhc_Node;
+
+	/** Every node prepares itself at the same time as the others: its memory is allocated
+	 *  and prefaulted, and the first block of its sensors generated (the initial nodes all
+	 *  start at revolution 0, and the first node of a group generates it for the group). */
+	_lhc_Node = allocate_Node(_sim, _task);
+	init_Sensor_Lane(&_bank._lane, _config->_sensor_Model, _task->_identifier, _task->_position/LHC_PERIMETER);
+	_bank._first = 0;
+	_bank._count = 0;
+	for(_channel=0;_channel<LHC_CHANNELS;_channel++) _bank._stride[_channel] = _lhc_Node ? _lhc_Node->_channels[_channel]._stride : 1;
+	if(_group && !_lhc_Node) {
+		leave_Sensor_Group(_group, _lane);
+		_group = NULL;
+	}
+	if(_group) fetch_Sensor_Group(_group, _lane, _config->_sensor_Model, _config->_seed, 0, _config->_number_Of_Measures, &_bank);
+
+	/** Set the MUTEX on */
+	pthread_mutex_lock(&_sim->_mutex);
+
+	/** A node without memory takes its turns, but captures nothing. */
+	if(!_lhc_Node) set_Error(_sim, ENOMEM);
+	else if(_config->_verbose) {
+		if(_added) printf("Done Creating node and allocating memory - LHC-Node: %d (added at %.0fm).\n", _lhc_Node->_identifier, _lhc_Node->_position);
+		else	   printf("Done Creating node and allocating memory - LHC-Node: %d.\n", _lhc_Node->_identifier);
+	}
+
+	/** Barrier: the last initial node to be ready starts the simulation. Nodes added while it
+	 *  runs find it started. */
+	if(!_added && ++_sim->_ready==_number_Of_Nodes) start_Sim(_sim);
+	while(!_sim->_started && !_sim->_abort) pthread_cond_wait(&_sim->_start, &_sim->_mutex);
+	if(_sim->_abort) {
+		pthread_mutex_unlock(&_sim->_mutex);
+		if(_group) leave_Sensor_Group(_group, _lane);
+		if(_lhc_Node) destroy_Node(_lhc_Node, 0);
+		return NULL;
+	}
+	pthread_mutex_unlock(&_sim->_mutex);
+
+	/** In paced mode the particle reaches the node position/speed after the origin of each
+	 *  revolution, and a revolution lasts perimeter/speed. */
+	if(_paced) init_Pacer(&_pacer, _sim->_origin, 1e9*LHC_PERIMETER/P_EXPECTED_SPEED,
+			1e9*_task->_position/P_EXPECTED_SPEED, _config->_pacing_Spin);
+
+	/** Monitors see the node as running before its first capture */
+	if(_sim->_telemetry && _lhc_Node) {
+		init_Telemetry_Snapshot(&_snapshot, _lhc_Node->_identifier, _lhc_Node->_position);
+		publish_Telemetry(_sim->_telemetry, _task->_identifier, &_snapshot);
+	}
+
+	/** Free and paced nodes know their first revolution at once; in sequential mode the ring
+	 *  tells it (the turn of a node added meanwhile comes at the next revolution). */
+	if(!_sequential) {
+		_first = join_Turn(_sim, _task);
+		if(_lhc_Node) _lhc_Node->_first_Turn = _first;
+	}
+
+	/** In order to achieve synchronization between threads... In sequential mode every node
+	 *  waits for the previous one (the particle reaches it just after), and hands the turn
+	 *  to the following one once its measure is captured. */
+	for(;;) {
+		/** The nodes of a group take their next block before their turn (the initial nodes
+		 *  capture every revolution from 0 on): it may wait for the slowest lane. */
+		if(_group && _captured < _config->_number_Of_Measures && _captured >= _bank._first+_bank._count)
+			fetch_Sensor_Group(_group, _lane, _config->_sensor_Model, _config->_seed, _captured,
+					_config->_number_Of_Measures-_captured, &_bank);
+
+		if(_sequential) {
+			pthread_mutex_lock(&_sim->_mutex);
+			if(!wait_Ring(_sim, _task)) {
+				pthread_mutex_unlock(&_sim->_mutex);
+				break;
+			}
+			/** A node removed while it held the turn hands it over before leaving */
+			if(__atomic_load_n(&_task->_retired, __ATOMIC_ACQUIRE)) {
+				pass_Ring(_sim, _task);
+				pthread_mutex_unlock(&_sim->_mutex);
+				break;
+			}
+			i = _sim->_revolution;
+			if(_captured==0) {
+				_first = i;
+				if(_lhc_Node) _lhc_Node->_first_Turn = i;
+			}
+		}
+
+		else {
+			i = _first + _captured;
+			if(i >= _config->_number_Of_Measures || __atomic_load_n(&_task->_retired, __ATOMIC_ACQUIRE)) break;
+			if(_paced) wait_Pacer(&_pacer, i);
+		}
+
+		if(_lhc_Node) capture_Measure(_lhc_Node, i, &_bank, _config);
+
+		/** The beam of the revolution is tracked ahead: a node only waits if it caught up */
+		if(_lhc_Node && _lhc_Node->_beam) {
+			const LHC_Beam_Position* _beam = wait_Tracker(_sim->_tracker, i, _monitor);
+			if(_beam) _lhc_Node->_beam[i - _first] = *_beam;
+		}
+		if(_captured++==0) first_Capture(_sim);
+		__atomic_store_n(&_task->_next_Turn, i+1, __ATOMIC_RELAXED);
+
+		/** Publishing never waits: monitors retry on their side */
+		if(_sim->_telemetry && _lhc_Node) {
+			decode_Measure(_lhc_Node, i - _first, &_measure);
+			update_Telemetry_Snapshot(&_snapshot, &_measure, i);
+			if(_captured%_interval==0) publish_Telemetry(_sim->_telemetry, _task->_identifier, &_snapshot);
+		}
+
+		if(_sequential) {
+			pass_Ring(_sim, _task);
+			pthread_mutex_unlock(&_sim->_mutex);
+		}
+		if(i+1 >= _config->_number_Of_Measures) break;
+	}
+	if(_lhc_Node) _lhc_Node->_number_Of_Measures = _captured;
+	if(_group) leave_Sensor_Group(_group, _lane);
+
+	if(_sim->_telemetry && _lhc_Node) {
+		_snapshot._state = LHC_TELEMETRY_FINISHED;
+		publish_Telemetry(_sim->_telemetry, _task->_identifier, &_snapshot);
+	}
+
+	/** File writing: every node formats its own file at the same time as the others,
+	 *  only the results are shared. */
+	if(_lhc_Node && _config->_write_Files) _error = write_Node(_sim, _lhc_Node);
+	if(_lhc_Node && _lhc_Node->_beam && _config->_write_Files && _error==0) _error = write_Beam(_sim, _lhc_Node);
+	if(_lhc_Node && _config->_series) copy_Series(_config->_series, _lhc_Node);
+
+	pthread_mutex_lock(&_sim->_mutex);
+	if(_paced) {
+		merge_Pacing_Stats(&_sim->_results._pacing, &_pacer._stats);
+		if(_config->_pacing_Stats) _config->_pacing_Stats[_task->_identifier] = _pacer._stats;
+	}
+	if(_lhc_Node) {
+		_sim->_results._measures_Captured += _captured;
+		for(_channel=0;_channel<LHC_CHANNELS;_channel++)
+			_sim->_results._measure_Bytes += channel_Bytes(_lhc_Node, _channel);
+		if(_error!=0) set_Error(_sim, _error);
+		else if(_config->_write_Files) _sim->_results._files_Written++;
+	}
+	pthread_mutex_unlock(&_sim->_mutex);
+
+	/** Destroy the Node */
+	if(_lhc_Node) destroy_Node(_lhc_Node, _config->_verbose);
+
+	return NULL;
 }
 
 /** Function to destroy the _lhc_Node and free memory */
-void destroy_Node( LHC_Node* _lhc_Node ) {
+void destroy_Node( LHC_Node* _lhc_Node, int _verbose ) {
 
 	/** Checking exist? */
 	assert( _lhc_Node );
@@ -200,10 +997,11 @@ void destroy_Node( LHC_Node* _lhc_Node ) {
 	_lhc_Node->_cadence 			= 0.0;
 
 	/** We free the previously allocated memory */
-	free( _lhc_Node->_measures);
+	free_Channels( _lhc_Node );
+	free( _lhc_Node->_beam );
 	free( _lhc_Node );
 
-	printf("Node %d. Destroyed.\n", _node_Id);
+	if(_verbose) printf("Node %d. Destroyed.\n", _node_Id);
 }
 
 /** Function to measure the time interval between Start and End of execution */
@@ -0,0 +1,273 @@
+//==============================================================================//
+//  Filename: lhc_spectrum.c													//
+//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+/* Local includes */
+#include "../include/lhc_spectrum.h"
+
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TWO_PI 6.28318530717958647692
+
+#define SPECTRUM_WINDOW 1024			/* Default turns per window. */
+#define SPECTRUM_STEP 256				/* Default turns between two windows. */
+#define SPECTRUM_LANES 4				/* Windows transformed at once, one per vector lane. */
+#define SPECTRUM_GROUP 4				/* Batches of a row per work item: its windows overlap in cache. */
+
+/** Four windows transformed at once: lane j of element t is turn t of the j-th window */
+typedef float v4f __attribute__((vector_size(16)));
+
+/** Work shared by the threads: every item is a group of windows of one row */
+typedef struct _Spectrum_Job{
+	const float*		_rows;
+	unsigned int		_turns;
+	LHC_Spectrum*		_spectrum;
+
+	/** Tables of the window size: bit reversed order, twiddles and Hann weights */
+	const unsigned int*	_reverse;
+	const float*		_cos;
+	const float*		_sin;
+	const float*		_hann;
+
+	unsigned int		_groups;			/** Items per row */
+	unsigned long		_number_Of_Items;
+	unsigned long		_next;
+	int					_error;
+} Spectrum_Job;
+
+void default_Spectrum_Config(LHC_Spectrum_Config *_config) {
+
+	memset(_config, 0, sizeof(LHC_Spectrum_Config));
+	_config->_window = SPECTRUM_WINDOW;
+	_config->_step = SPECTRUM_STEP;
+	_config->_threads = 0;
+}
+
+/** Function to load up to SPECTRUM_LANES windows of a row from 'first' (centered, weighted and in
+ *  bit reversed order). The lanes past the last window are zero. */
+static void load_Batch(const Spectrum_Job *_job, unsigned int _row, unsigned int _first, v4f *_re, v4f *_im) {
+
+	const LHC_Spectrum*	_spectrum = _job->_spectrum;
+	const unsigned int	n = _spectrum->_window;
+	unsigned int		j, t;
+
+	memset(_re, 0, n*sizeof(v4f));
+	memset(_im, 0, n*sizeof(v4f));
+	for(j=0;j<SPECTRUM_LANES && _first+j<_spectrum->_number_Of_Windows;j++) {
+		const float*	x = _job->_rows + (size_t)_row*_job->_turns + (size_t)(_first+j)*_spectrum->_step;
+		double			_sum = 0;
+		float			_mean;
+
+		for(t=0;t<n;t++) _sum += x[t];
+		_mean = (float)(_sum/n);
+		for(t=0;t<n;t++) _re[_job->_reverse[t]][j] = (x[t] - _mean)*_job->_hann[t];
+	}
+}
+
+/** Function to transform the batch in place (radix 2, decimation in time): every butterfly
+ *  works on all the lanes at once */
+static void transform_Batch(const Spectrum_Job *_job, v4f *_re, v4f *_im) {
+
+	const unsigned int	n = _job->_spectrum->_window;
+	unsigned int		_half, _stride, i, k;
+
+	for(_half=1;_half<n;_half<<=1) {
+		_stride = n/(2*_half);
+		for(i=0;i<n;i+=2*_half) {
+			for(k=0;k<_half;k++) {
+				const float	c = _job->_cos[k*_stride], s = _job->_sin[k*_stride];
+				const v4f	_wr = { c, c, c, c }, _wi = { s, s, s, s };
+				const unsigned int a = i+k, b = a+_half;
+
+				/** (re + i im)(c - i s) */
+				v4f _tr = _re[b]*_wr + _im[b]*_wi;
+				v4f _ti = _im[b]*_wr - _re[b]*_wi;
+
+				_re[b] = _re[a] - _tr;
+				_im[b] = _im[a] - _ti;
+				_re[a] += _tr;
+				_im[a] += _ti;
+			}
+		}
+	}
+}
+
+/** Function to keep the strongest line of every window of the batch. Its frequency and height
+ *  are refined with a parabola through the bin and its neighbours, only when the bin is a
+ *  true local maximum away from DC (a trend or a step leaks a large DC term through the Hann
+ *  weights, which would drag the parabola out of the bin). */
+static void pick_Peaks(const Spectrum_Job *_job, unsigned int _row, unsigned int _first, v4f *_re, const v4f *_im) {
+
+	LHC_Spectrum*		_spectrum = _job->_spectrum;
+	const unsigned int	n = _spectrum->_window;
+	unsigned int		j, k, _best;
+
+	/** Magnitudes (DC to Nyquist) overwrite the real parts */
+	for(k=0;k<=n/2;k++) {
+		v4f _power = _re[k]*_re[k] + _im[k]*_im[k];
+
+		for(j=0;j<SPECTRUM_LANES;j++) _re[k][j] = sqrtf(_power[j]);
+	}
+
+	for(j=0;j<SPECTRUM_LANES && _first+j<_spectrum->_number_Of_Windows;j++) {
+		LHC_Spectrum_Peak*	_peak = &SPECTRUM_PEAK(_spectrum, _row, _first+j);
+		float				a, b, c, d, _delta = 0;
+
+		for(_best=1, k=2;k<=n/2;k++) if(_re[k][j] > _re[_best][j]) _best = k;
+		b = _re[_best][j];
+		if(_best > 1 && _best < n/2) {
+			a = _re[_best-1][j];
+			c = _re[_best+1][j];
+			d = a - 2*b + c;
+			if(a <= b && c <= b && d < 0) {
+				_delta = 0.5f*(a - c)/d;
+				if(_delta > 0.5f) _delta = 0.5f;
+				if(_delta < -0.5f) _delta = -0.5f;
+				b -= 0.25f*(a - c)*_delta;
+			}
+		}
+		_peak->_frequency = (_best + _delta)/n;
+		/** The Hann window keeps half of the amplitude */
+		_peak->_amplitude = 2*b/(0.5f*n);
+	}
+}
+
+/** Thread: takes items (row, group of batches) until there is none left */
+static void* spectrum_Worker(void *_arg) {
+
+	Spectrum_Job*	_job = ( Spectrum_Job* ) _arg;
+	unsigned int	n = _job->_spectrum->_window, _row, _first, b;
+	unsigned long	_item;
+	v4f*			_re = ( v4f* ) malloc( n*sizeof( v4f ) );
+	v4f*			_im = ( v4f* ) malloc( n*sizeof( v4f ) );
+
+	if(!_re || !_im) {
+		__atomic_store_n(&_job->_error, ENOMEM, __ATOMIC_RELAXED);
+		free(_re);
+		free(_im);
+		return NULL;
+	}
+
+	while((_item = __atomic_fetch_add(&_job->_next, 1, __ATOMIC_RELAXED)) < _job->_number_Of_Items) {
+		_row = _item / _job->_groups;
+		for(b=0;b<SPECTRUM_GROUP;b++) {
+			_first = ((_item % _job->_groups)*SPECTRUM_GROUP + b)*SPECTRUM_LANES;
+			if(_first >= _job->_spectrum->_number_Of_Windows) break;
+			load_Batch(_job, _row, _first, _re, _im);
+			transform_Batch(_job, _re, _im);
+			pick_Peaks(_job, _row, _first, _re, _im);
+		}
+	}
+
+	free(_re);
+	free(_im);
+	return NULL;
+}
+
+void destroy_Spectrum(LHC_Spectrum *_spectrum) {
+
+	if(!_spectrum) return;
+	free(_spectrum->_peaks);
+	free(_spectrum);
+}
+
+/** Function to analyse every window of every row */
+LHC_Spectrum* analyse_Spectrum(const float *_rows, unsigned int _number_Of_Rows, unsigned int _turns, const LHC_Spectrum_Config *_config) {
+
+	LHC_Spectrum*	_spectrum;
+	Spectrum_Job	_job;
+	pthread_t*		_threads;
+	unsigned int*	_reverse;
+	float*			_tables;
+	unsigned int	n, _step, _bits=0, _threads_Wanted, t, b, i, _created=0;
+	unsigned long	_batches;
+
+	if(!_rows || !_config || _number_Of_Rows==0) {
+		errno = EINVAL;
+		return NULL;
+	}
+	n = _config->_window;
+	_step = _config->_step ? _config->_step : n;
+	if(n<4 || (n & (n-1))!=0 || n>_turns) {
+		errno = EINVAL;
+		return NULL;
+	}
+	while((1u<<_bits) < n) _bits++;
+	_threads_Wanted = _config->_threads ? _config->_threads : (unsigned int)sysconf(_SC_NPROCESSORS_ONLN);
+	if(_threads_Wanted==0) _threads_Wanted = 1;
+
+	_spectrum = ( LHC_Spectrum* ) calloc( 1, sizeof( LHC_Spectrum ) );
+	if(!_spectrum) return NULL;
+	_spectrum->_number_Of_Rows = _number_Of_Rows;
+	_spectrum->_number_Of_Windows = (_turns - n)/_step + 1;
+	_spectrum->_window = n;
+	_spectrum->_step = _step;
+	_spectrum->_peaks = ( LHC_Spectrum_Peak* ) calloc( (size_t)_number_Of_Rows*_spectrum->_number_Of_Windows, sizeof( LHC_Spectrum_Peak ) );
+	_reverse = ( unsigned int* ) malloc( n*sizeof( unsigned int ) );
+	_tables = ( float* ) malloc( 2*n*sizeof( float ) );
+	_threads = ( pthread_t* ) calloc( _threads_Wanted, sizeof( pthread_t ) );
+	if(!_spectrum->_peaks || !_reverse || !_tables || !_threads) {
+		free(_threads);
+		free(_tables);
+		free(_reverse);
+		destroy_Spectrum(_spectrum);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	/** Tables shared by all the transforms: twiddles e^(-2 pi i k/n) for k < n/2, Hann weights */
+	for(t=0;t<n;t++) {
+		unsigned int r=0;
+
+		for(b=0;b<_bits;b++) r |= ((t>>b)&1u) << (_bits-1-b);
+		_reverse[t] = r;
+	}
+	for(t=0;t<n/2;t++) {
+		_tables[t] = (float)cos(TWO_PI*t/n);
+		_tables[n/2+t] = (float)sin(TWO_PI*t/n);
+	}
+	for(t=0;t<n;t++) _tables[n+t] = (float)(0.5 - 0.5*cos(TWO_PI*t/n));
+
+	/** All rows and groups of windows are shared between the threads */
+	_batches = (_spectrum->_number_Of_Windows + SPECTRUM_LANES-1)/SPECTRUM_LANES;
+	_job._rows = _rows;
+	_job._turns = _turns;
+	_job._spectrum = _spectrum;
+	_job._reverse = _reverse;
+	_job._cos = _tables;
+	_job._sin = _tables + n/2;
+	_job._hann = _tables + n;
+	_job._groups = (unsigned int)((_batches + SPECTRUM_GROUP-1)/SPECTRUM_GROUP);
+	_job._number_Of_Items = (unsigned long)_number_Of_Rows*_job._groups;
+	_job._next = 0;
+	_job._error = 0;
+	if(_threads_Wanted > _job._number_Of_Items) _threads_Wanted = _job._number_Of_Items;
+
+	for(i=1;i<_threads_Wanted;i++) {
+		if(pthread_create(&_threads[i], NULL, spectrum_Worker, &_job)!=0) break;
+		_created++;
+	}
+	spectrum_Worker(&_job);
+	for(i=1;i<=_created;i++) pthread_join(_threads[i], NULL);
+
+	free(_threads);
+	free(_tables);
+	free(_reverse);
+
+	/** A thread without memory left its items: the others took them, unless none had any */
+	if(_job._error!=0 && _job._next < _job._number_Of_Items) {
+		destroy_Spectrum(_spectrum);
+		errno = _job._error;
+		return NULL;
+	}
+	return _spectrum;
+}
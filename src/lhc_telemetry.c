@@ -0,0 +1,252 @@
+//==============================================================================//
+//  Filename: lhc_telemetry.c													//
+//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+/* Local includes */
+#include "../include/lhc_simulator.h"
+#include "../include/lhc_telemetry.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TELEMETRY_READ_TRIES 1000		/* Attempts of a reader before giving up on a slot. */
+
+/** Weight of a new capture in the rolling statistics */
+#define TELEMETRY_ALPHA (2.0f/(LHC_TELEMETRY_WINDOW+1))
+
+/** Function to know the bytes of a segment with 'slots' slots */
+static size_t telemetry_Size(unsigned int _slots) {
+	return sizeof(LHC_Telemetry_Header) + (size_t)_slots*sizeof(LHC_Telemetry_Slot);
+}
+
+/** Function to know whether an existing segment may be replaced: it is not a telemetry
+ *  segment, its run is finished or its simulator is gone */
+static int stale_Telemetry(const char *_name) {
+
+	LHC_Telemetry_Header	_header;
+	int						_fd, _stale=1;
+
+	_fd = shm_open(_name, O_RDONLY, 0);
+	if(_fd<0) return errno==ENOENT;
+	if(pread(_fd, &_header, sizeof(_header), 0)==(ssize_t)sizeof(_header) &&
+			memcmp(_header._magic, LHC_TELEMETRY_MAGIC, sizeof(_header._magic))==0 &&
+			_header._state!=LHC_TELEMETRY_FINISHED &&
+			(kill((pid_t)_header._pid, 0)==0 || errno!=ESRCH)) _stale = 0;
+	close(_fd);
+
+	return _stale;
+}
+
+LHC_Telemetry* create_Telemetry(const char *_name, unsigned int _slots, unsigned int _measures) {
+
+	LHC_Telemetry*	_telemetry;
+	void*			_map;
+	int				_fd, _error;
+
+	if(!_name || _slots==0 || strlen(_name) >= sizeof(_telemetry->_name)) {
+		errno = EINVAL;
+		return NULL;
+	}
+	_telemetry = ( LHC_Telemetry* ) calloc( 1, sizeof( LHC_Telemetry ) );
+	if(!_telemetry) return NULL;
+	_telemetry->_size = telemetry_Size(_slots);
+	strcpy(_telemetry->_name, _name);
+
+	/** A segment is never truncated under a simulator still mapping it: one left by a
+	 *  previous run with the same name is unlinked (readers keep their mapping) and a new one
+	 *  created, but a live one makes this run fail with EBUSY. */
+	_fd = shm_open(_name, O_CREAT | O_EXCL | O_RDWR, 0644);
+	if(_fd<0 && errno==EEXIST) {
+		if(stale_Telemetry(_name)) {
+			shm_unlink(_name);
+			_fd = shm_open(_name, O_CREAT | O_EXCL | O_RDWR, 0644);
+		}
+		else errno = EBUSY;
+	}
+	if(_fd<0 || ftruncate(_fd, _telemetry->_size)!=0 ||
+			(_map = mmap(NULL, _telemetry->_size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0))==MAP_FAILED) {
+		_error = errno;
+		if(_fd>=0) {
+			close(_fd);
+			shm_unlink(_name);
+		}
+		free(_telemetry);
+		errno = _error;
+		return NULL;
+	}
+	close(_fd);
+
+	/** ftruncate gave zeros: every slot is idle with an even sequence */
+	_telemetry->_header = ( LHC_Telemetry_Header* ) _map;
+	_telemetry->_slots = ( LHC_Telemetry_Slot* ) (_telemetry->_header + 1);
+	_telemetry->_header->_slot_Size = sizeof(LHC_Telemetry_Slot);
+	_telemetry->_header->_number_Of_Slots = _slots;
+	_telemetry->_header->_number_Of_Measures = _measures;
+	_telemetry->_header->_pid = (int32_t)getpid();
+	_telemetry->_header->_state = LHC_TELEMETRY_RUNNING;
+
+	/** The magic goes last: a reader finding it finds the rest of the header */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(_telemetry->_header->_magic, LHC_TELEMETRY_MAGIC, sizeof(_telemetry->_header->_magic));
+
+	return _telemetry;
+}
+
+void destroy_Telemetry(LHC_Telemetry *_telemetry) {
+
+	if(!_telemetry) return;
+	__atomic_store_n(&_telemetry->_header->_state, LHC_TELEMETRY_FINISHED, __ATOMIC_RELEASE);
+	munmap(_telemetry->_header, _telemetry->_size);
+	shm_unlink(_telemetry->_name);
+	free(_telemetry);
+}
+
+LHC_Telemetry* open_Telemetry(const char *_name) {
+
+	LHC_Telemetry*			_telemetry;
+	LHC_Telemetry_Header	_header;
+	struct stat				_stat;
+	void*					_map;
+	int						_fd, _error;
+
+	if(!_name || strlen(_name) >= sizeof(_telemetry->_name)) {
+		errno = EINVAL;
+		return NULL;
+	}
+	_fd = shm_open(_name, O_RDONLY, 0);
+	if(_fd<0) return NULL;
+
+	/** The segment must be a whole header and as many slots as it announces */
+	_error = 0;
+	if(fstat(_fd, &_stat)!=0) _error = errno;
+	else if(pread(_fd, &_header, sizeof(_header), 0)!=(ssize_t)sizeof(_header) ||
+			memcmp(_header._magic, LHC_TELEMETRY_MAGIC, sizeof(_header._magic))!=0 ||
+			_header._slot_Size!=sizeof(LHC_Telemetry_Slot) ||
+			(size_t)_stat.st_size < telemetry_Size(_header._number_Of_Slots)) _error = EPROTO;
+	if(_error!=0) {
+		close(_fd);
+		errno = _error;
+		return NULL;
+	}
+
+	_telemetry = ( LHC_Telemetry* ) calloc( 1, sizeof( LHC_Telemetry ) );
+	if(!_telemetry) {
+		close(_fd);
+		return NULL;
+	}
+	_telemetry->_size = telemetry_Size(_header._number_Of_Slots);
+	_map = mmap(NULL, _telemetry->_size, PROT_READ, MAP_SHARED, _fd, 0);
+	_error = errno;
+	close(_fd);
+	if(_map==MAP_FAILED) {
+		free(_telemetry);
+		errno = _error;
+		return NULL;
+	}
+	_telemetry->_header = ( LHC_Telemetry_Header* ) _map;
+	_telemetry->_slots = ( LHC_Telemetry_Slot* ) (_telemetry->_header + 1);
+	strcpy(_telemetry->_name, _name);
+
+	return _telemetry;
+}
+
+void close_Telemetry(LHC_Telemetry *_telemetry) {
+
+	if(!_telemetry) return;
+	munmap(_telemetry->_header, _telemetry->_size);
+	free(_telemetry);
+}
+
+void init_Telemetry_Snapshot(LHC_Telemetry_Snapshot *_snapshot, unsigned int _identifier, float _position) {
+
+	memset(_snapshot, 0, sizeof(LHC_Telemetry_Snapshot));
+	_snapshot->_identifier = _identifier;
+	_snapshot->_position = _position;
+	_snapshot->_state = LHC_TELEMETRY_RUNNING;
+}
+
+void update_Telemetry_Snapshot(LHC_Telemetry_Snapshot *_snapshot, const Measure *_measure, unsigned int _turn) {
+
+	unsigned int _channel;
+
+	_snapshot->_value[LHC_PARTICLE_RADIATION] = _measure->_particle_Radiation;
+	_snapshot->_value[LHC_PARTICLE_SPEED] = _measure->_particle_Speed;
+	_snapshot->_value[LHC_MAGNET_CURRENT] = _measure->_magnet_Current;
+	_snapshot->_value[LHC_HELIUM_TEMP] = _measure->_helium_Temp;
+	_snapshot->_value[LHC_HELIUM_PRESSURE] = _measure->_helium_Pressure;
+	_snapshot->_value[LHC_PHASE_RF] = _measure->_phase_RF;
+
+	/** Exponentially weighted mean and variance; the first capture sets them all */
+	for(_channel=0;_channel<LHC_CHANNELS;_channel++) {
+		float x = _snapshot->_value[_channel];
+
+		if(_snapshot->_captures==0) {
+			_snapshot->_mean[_channel] = _snapshot->_min[_channel] = _snapshot->_max[_channel] = x;
+			_snapshot->_variance[_channel] = 0;
+		} else {
+			float _delta = x - _snapshot->_mean[_channel];
+
+			_snapshot->_mean[_channel] += TELEMETRY_ALPHA*_delta;
+			_snapshot->_variance[_channel] = (1.0f-TELEMETRY_ALPHA)*(_snapshot->_variance[_channel] + TELEMETRY_ALPHA*_delta*_delta);
+			if(x < _snapshot->_min[_channel]) _snapshot->_min[_channel] = x;
+			if(x > _snapshot->_max[_channel]) _snapshot->_max[_channel] = x;
+		}
+	}
+	_snapshot->_captures++;
+	_snapshot->_turn = _turn;
+}
+
+/** Seqlock writer: odd sequence, data, even sequence. The node is the only writer of its
+ *  slot, so it never waits. */
+void publish_Telemetry(LHC_Telemetry *_telemetry, unsigned int _slot, const LHC_Telemetry_Snapshot *_snapshot) {
+
+	LHC_Telemetry_Slot* _target;
+	uint32_t			_sequence;
+
+	if(!_telemetry || _slot >= _telemetry->_header->_number_Of_Slots) return;
+	_target = &_telemetry->_slots[_slot];
+
+	_sequence = __atomic_load_n(&_target->_sequence, __ATOMIC_RELAXED);
+	__atomic_store_n(&_target->_sequence, _sequence+1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	memcpy(&_target->_snapshot, _snapshot, sizeof(LHC_Telemetry_Snapshot));
+	_target->_snapshot._time = monotonic_Now();
+
+	__atomic_store_n(&_target->_sequence, _sequence+2, __ATOMIC_RELEASE);
+}
+
+/** Seqlock reader: the copy is kept only if the sequence was even and did not change */
+int read_Telemetry(const LHC_Telemetry *_telemetry, unsigned int _slot, LHC_Telemetry_Snapshot *_snapshot) {
+
+	const LHC_Telemetry_Slot*	_source;
+	uint32_t					_before, _after;
+	unsigned int				_try;
+
+	if(!_telemetry || _slot >= _telemetry->_header->_number_Of_Slots) {
+		errno = EINVAL;
+		return -1;
+	}
+	_source = &_telemetry->_slots[_slot];
+
+	for(_try=0;_try<TELEMETRY_READ_TRIES;_try++) {
+		_before = __atomic_load_n(&_source->_sequence, __ATOMIC_ACQUIRE);
+		if(_before & 1) continue;
+
+		memcpy(_snapshot, &_source->_snapshot, sizeof(LHC_Telemetry_Snapshot));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+		_after = __atomic_load_n(&_source->_sequence, __ATOMIC_RELAXED);
+		if(_before==_after) return 0;
+	}
+	errno = EAGAIN;
+	return -1;
+}
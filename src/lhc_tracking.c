@@ -0,0 +1,607 @@
+//==============================================================================//
+//  Filename: lhc_tracking.c													//
+//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+/* Local includes */
+#include "../include/lhc_tracking.h"
+#include "../include/lhc_pacing.h"
+#include "../include/lhc_sensor.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TWO_PI 6.28318530717958647692
+
+#define QUADRUPOLE_LENGTH 3.1			/* Main LHC quadrupoles (m). */
+#define DIPOLE_LENGTH 14.3				/* Main LHC dipoles (m). */
+#define CELL_DIPOLES 6					/* Dipoles per FODO cell. */
+#define MATCH_ITERATIONS 50				/* Newton steps matching the tunes. */
+
+#define TRACK_PARTICLES 256				/* Particles kept in cache while a block of turns runs. */
+#define TRACK_TURNS 64					/* Turns between two merges of the threads. */
+
+/** Four particles processed at once. Particles are tracked in double: the maps are applied
+ *  millions of times, and float rounding would make the beam grow or shrink. The vectors are
+ *  passed by address, so the code does not depend on AVX being enabled. */
+typedef double v4d __attribute__((vector_size(32)));
+
+static inline void load_V4D(v4d *_v, const double *_p) {
+	memcpy(_v, _p, sizeof(v4d));
+}
+
+static inline void store_V4D(double *_p, const v4d *_v) {
+	memcpy(_p, _v, sizeof(v4d));
+}
+
+static inline double sum_V4D(const v4d *_v) {
+	return ((*_v)[0]+(*_v)[1]) + ((*_v)[2]+(*_v)[3]);
+}
+
+
+/*  MATRICES  */
+/*~~~~~~~~~~~~*/
+/** Function to set the matrix of a drift of length 'l' */
+static void drift_Matrix(double l, double *m) {
+	m[0] = 1.0; m[1] = l;
+	m[2] = 0.0; m[3] = 1.0;
+}
+
+/** Function to set the matrix of a focusing strength 'k' (1/m^2) over 'l' (k < 0 defocuses) */
+static void focus_Matrix(double k, double l, double *m) {
+
+	double s = sqrt(fabs(k)), _phi = s*l;
+
+	if(k>0) {
+		m[0] = cos(_phi);	m[1] = sin(_phi)/s;
+		m[2] = -s*sin(_phi);m[3] = cos(_phi);
+	} else if(k<0) {
+		m[0] = cosh(_phi);	m[1] = sinh(_phi)/s;
+		m[2] = s*sinh(_phi);m[3] = cosh(_phi);
+	} else drift_Matrix(l, m);
+}
+
+/** Function to set the matrices of the first 'l' metres of an element */
+static void element_Matrices(const LHC_Element *_element, double l, double *_mx, double *_my) {
+
+	switch(_element->_kind) {
+	case LHC_ELEMENT_DIPOLE:
+		/** Curvature h focuses the bending plane like k = h^2 */
+		focus_Matrix(pow(_element->_strength/_element->_length, 2), l, _mx);
+		drift_Matrix(l, _my);
+		break;
+	case LHC_ELEMENT_QUADRUPOLE:
+		focus_Matrix(_element->_strength, l, _mx);
+		focus_Matrix(-_element->_strength, l, _my);
+		break;
+	default:
+		drift_Matrix(l, _mx);
+		drift_Matrix(l, _my);
+	}
+}
+
+/** Function to apply 'e' after 'm' (m = e*m) */
+static void compose_Matrix(double *m, const double *e) {
+
+	double _r[4];
+
+	_r[0] = e[0]*m[0] + e[1]*m[2];
+	_r[1] = e[0]*m[1] + e[1]*m[3];
+	_r[2] = e[2]*m[0] + e[3]*m[2];
+	_r[3] = e[2]*m[1] + e[3]*m[3];
+	memcpy(m, _r, sizeof(_r));
+}
+
+/** Function called with the matrices of every piece of element walked */
+typedef void (*Piece_Function)(const double *, const double *, void *);
+
+/** Function to walk 'distance' metres of the ring from 'from', piece of element by piece */
+static void walk_Lattice(const LHC_Lattice *_lattice, double _from, double _distance, Piece_Function _function, void *_arg) {
+
+	unsigned int	i=0;
+	double			s=0.0, _offset, l, _mx[4], _my[4];
+
+	_from = fmod(_from, _lattice->_length);
+	if(_from<0) _from += _lattice->_length;
+	while(i+1<_lattice->_number_Of_Elements && s + _lattice->_elements[i]._length <= _from) s += _lattice->_elements[i++]._length;
+	_offset = _from - s;
+
+	while(_distance > 1e-9) {
+		const LHC_Element* _element = &_lattice->_elements[i];
+
+		l = _element->_length - _offset;
+		if(l > _distance) l = _distance;
+		if(l > 0) {
+			element_Matrices(_element, l, _mx, _my);
+			_function(_mx, _my, _arg);
+			_distance -= l;
+		}
+		_offset = 0.0;
+		i = (i+1) % _lattice->_number_Of_Elements;
+	}
+}
+
+/** Piece_Function composing the maps of both planes (arg: 8 doubles) */
+static void compose_Piece(const double *_mx, const double *_my, void *_arg) {
+
+	double* _maps = ( double* ) _arg;
+
+	compose_Matrix(_maps, _mx);
+	compose_Matrix(_maps+4, _my);
+}
+
+void lattice_Map(const LHC_Lattice *_lattice, double _from, double _to, double *_mx, double *_my) {
+
+	double _maps[8] = { 1, 0, 0, 1, 1, 0, 0, 1 };
+	double _distance = fmod(_to - _from, _lattice->_length);
+
+	if(_distance <= 0) _distance += _lattice->_length;
+	walk_Lattice(_lattice, _from, _distance, compose_Piece, _maps);
+	memcpy(_mx, _maps, 4*sizeof(double));
+	memcpy(_my, _maps+4, 4*sizeof(double));
+}
+
+
+/*  OPTICS  */
+/*~~~~~~~~~~*/
+/** Function to get beta and alpha from a one-turn matrix. Returns -1 if the motion is not stable. */
+static int periodic_Twiss(const double *m, LHC_Twiss *_twiss) {
+
+	double _cos = (m[0] + m[3])/2, _sin;
+
+	if(!(fabs(_cos) < 1.0)) return -1;
+	_sin = sqrt(1.0 - _cos*_cos);
+	if(m[1] < 0) _sin = -_sin;
+	_twiss->_beta = m[1]/_sin;
+	_twiss->_alpha = (m[0] - m[3])/(2*_sin);
+	_twiss->_tune = 0.0;
+
+	return 0;
+}
+
+/** Piece_Function propagating the optics of both planes and adding up their phase advance */
+static void advance_Piece(const double *_mx, const double *_my, void *_arg) {
+
+	LHC_Twiss*		_twiss = ( LHC_Twiss* ) _arg;
+	const double*	_m[2] = { _mx, _my };
+	unsigned int	p;
+
+	for(p=0;p<2;p++) {
+		const double*	m = _m[p];
+		double			b = _twiss[p]._beta, a = _twiss[p]._alpha;
+		double			u = m[0]*b - m[1]*a, v = m[2]*b - m[3]*a;
+
+		_twiss[p]._tune += atan2(m[1], u)/TWO_PI;
+		_twiss[p]._beta = (u*u + m[1]*m[1])/b;
+		_twiss[p]._alpha = -(u*v + m[1]*m[3])/b;
+	}
+}
+
+int lattice_Twiss(const LHC_Lattice *_lattice, double _position, LHC_Twiss *_x, LHC_Twiss *_y) {
+
+	double		_mx[4], _my[4];
+	LHC_Twiss	_twiss[2];
+
+	lattice_Map(_lattice, _position, _position, _mx, _my);
+	if(periodic_Twiss(_mx, &_twiss[0])!=0 || periodic_Twiss(_my, &_twiss[1])!=0) {
+		errno = EDOM;
+		return -1;
+	}
+	*_x = _twiss[0];
+	*_y = _twiss[1];
+
+	/** The tunes come from the phase advance all along the ring */
+	walk_Lattice(_lattice, _position, _lattice->_length, advance_Piece, _twiss);
+	_x->_tune = _twiss[0]._tune;
+	_y->_tune = _twiss[1]._tune;
+
+	return 0;
+}
+
+
+/*  LATTICE  */
+/*~~~~~~~~~~~*/
+void default_Beam_Config(LHC_Beam_Config *_beam) {
+
+	memset(_beam, 0, sizeof(LHC_Beam_Config));
+	_beam->_particles = 0;
+	_beam->_cells = 204;
+	_beam->_tune_X = 64.31;
+	_beam->_tune_Y = 59.32;
+	_beam->_emittance = 5.0e-10;		/** 3.75um normalised, at 7 TeV */
+	_beam->_offset_X = 1.0e-4;
+	_beam->_offset_Y = 0.5e-4;
+	_beam->_threads = 0;
+}
+
+/** Function to set one FODO cell: QF/2 (BBB) QD (BBB) QF/2 with drifts around the dipoles */
+static void set_FODO_Cell(LHC_Element *_cell, double _length, double _angle, double _kf, double _kd) {
+
+	double			_dipole = DIPOLE_LENGTH, _drift;
+	unsigned int	i, n=0;
+
+	/** Short cells get shorter dipoles */
+	if(2*QUADRUPOLE_LENGTH + CELL_DIPOLES*_dipole > 0.8*_length) _dipole = (0.8*_length - 2*QUADRUPOLE_LENGTH)/CELL_DIPOLES;
+	_drift = (_length - 2*QUADRUPOLE_LENGTH - CELL_DIPOLES*_dipole)/(CELL_DIPOLES+2);
+
+	_cell[n++] = (LHC_Element){ LHC_ELEMENT_QUADRUPOLE, QUADRUPOLE_LENGTH/2, _kf };
+	for(i=0;i<CELL_DIPOLES;i++) {
+		_cell[n++] = (LHC_Element){ LHC_ELEMENT_DRIFT, _drift, 0.0 };
+		_cell[n++] = (LHC_Element){ LHC_ELEMENT_DIPOLE, _dipole, _angle };
+		if(i==CELL_DIPOLES/2-1) {
+			_cell[n++] = (LHC_Element){ LHC_ELEMENT_DRIFT, _drift, 0.0 };
+			_cell[n++] = (LHC_Element){ LHC_ELEMENT_QUADRUPOLE, QUADRUPOLE_LENGTH, _kd };
+		}
+	}
+	_cell[n++] = (LHC_Element){ LHC_ELEMENT_DRIFT, _drift, 0.0 };
+	_cell[n++] = (LHC_Element){ LHC_ELEMENT_QUADRUPOLE, QUADRUPOLE_LENGTH/2, _kf };
+}
+
+#define CELL_ELEMENTS (2*CELL_DIPOLES+5)
+
+/** Function to know the phase advances of one cell. Returns -1 if it is not stable. */
+static int cell_Phase(double _length, double _angle, double _kf, double _kd, double *_mu) {
+
+	LHC_Element		_cell[CELL_ELEMENTS];
+	LHC_Lattice		_lattice = { CELL_ELEMENTS, _cell, _length };
+	double			_mx[4], _my[4], _cx, _cy;
+
+	set_FODO_Cell(_cell, _length, _angle, _kf, _kd);
+	lattice_Map(&_lattice, 0.0, 0.0, _mx, _my);
+	_cx = (_mx[0]+_mx[3])/2;
+	_cy = (_my[0]+_my[3])/2;
+	if(!(fabs(_cx)<1.0 && fabs(_cy)<1.0)) return -1;
+	_mu[0] = acos(_cx);
+	_mu[1] = acos(_cy);
+
+	return 0;
+}
+
+LHC_Lattice* create_FODO_Lattice(double _circumference, unsigned int _cells, double _tune_X, double _tune_Y) {
+
+	LHC_Lattice*	_lattice;
+	double			_length, _angle, _target[2], _mu[2], _mu_F[2], _mu_D[2], _f, _kf, _kd, h, _det;
+	unsigned int	i, _iteration;
+
+	if(_cells==0 || !(_circumference>0) || !(_tune_X>0 && _tune_X<_cells/2.0) || !(_tune_Y>0 && _tune_Y<_cells/2.0)) {
+		errno = EDOM;
+		return NULL;
+	}
+	_length = _circumference/_cells;
+	_angle = TWO_PI/(CELL_DIPOLES*_cells);
+	_target[0] = TWO_PI*_tune_X/_cells;
+	_target[1] = TWO_PI*_tune_Y/_cells;
+
+	/** Thin lens guess, then Newton on both quadrupole strengths */
+	_f = _length/(4*sin((_target[0]+_target[1])/4));
+	_kf = 1.0/(_f*QUADRUPOLE_LENGTH);
+	_kd = -_kf;
+	for(_iteration=0;_iteration<MATCH_ITERATIONS;_iteration++) {
+		h = 1e-7*fabs(_kf);
+		if(cell_Phase(_length, _angle, _kf, _kd, _mu)!=0 ||
+				cell_Phase(_length, _angle, _kf+h, _kd, _mu_F)!=0 ||
+				cell_Phase(_length, _angle, _kf, _kd+h, _mu_D)!=0) break;
+		if(fabs(_mu[0]-_target[0]) < 1e-13 && fabs(_mu[1]-_target[1]) < 1e-13) break;
+
+		/** Jacobian [d mu / d kf, d mu / d kd] */
+		{
+			double a = (_mu_F[0]-_mu[0])/h, b = (_mu_D[0]-_mu[0])/h;
+			double c = (_mu_F[1]-_mu[1])/h, d = (_mu_D[1]-_mu[1])/h;
+			double _ex = _target[0]-_mu[0], _ey = _target[1]-_mu[1];
+
+			_det = a*d - b*c;
+			if(_det==0) break;
+			_kf += ( d*_ex - b*_ey)/_det;
+			_kd += (-c*_ex + a*_ey)/_det;
+		}
+	}
+	if(cell_Phase(_length, _angle, _kf, _kd, _mu)!=0 || fabs(_mu[0]-_target[0]) > 1e-9 || fabs(_mu[1]-_target[1]) > 1e-9) {
+		errno = EDOM;
+		return NULL;
+	}
+
+	_lattice = ( LHC_Lattice* ) malloc( sizeof( LHC_Lattice ) );
+	if(!_lattice) return NULL;
+	_lattice->_number_Of_Elements = _cells*CELL_ELEMENTS;
+	_lattice->_length = _circumference;
+	_lattice->_elements = ( LHC_Element* ) malloc( _lattice->_number_Of_Elements*sizeof( LHC_Element ) );
+	if(!_lattice->_elements) {
+		free(_lattice);
+		return NULL;
+	}
+	for(i=0;i<_cells;i++) set_FODO_Cell(_lattice->_elements + i*CELL_ELEMENTS, _length, _angle, _kf, _kd);
+
+	return _lattice;
+}
+
+void destroy_Lattice(LHC_Lattice *_lattice) {
+
+	if(!_lattice) return;
+	free(_lattice->_elements);
+	free(_lattice);
+}
+
+
+/*  TRACKING  */
+/*~~~~~~~~~~~~*/
+/** Function to track 'count' particles from 'first' over 'turns' turns. At every monitor the
+ *  sums of x, x^2, y and y^2 are added to 'sums' ([turn][monitor][4]), then the map to the
+ *  next monitor is applied. The particles stay in cache for all the turns of the block. */
+static void track_Particles(LHC_Tracker *_tracker, unsigned int _first, unsigned int _count, unsigned int _turns, double *_sums) {
+
+	const unsigned int	_monitors = _tracker->_number_Of_Monitors;
+	double* 			_x = _tracker->_x;
+	double* 			_px = _tracker->_px;
+	double* 			_y = _tracker->_y;
+	double* 			_py = _tracker->_py;
+	unsigned int		p, n, t, k, i;
+
+	for(p=_first;p<_first+_count;p+=TRACK_PARTICLES) {
+		n = (_first+_count-p < TRACK_PARTICLES) ? _first+_count-p : TRACK_PARTICLES;
+
+		for(t=0;t<_turns;t++) {
+			for(k=0;k<_monitors;k++) {
+				const double*	m = &_tracker->_maps[k*8];
+				const v4d		a = { m[0], m[0], m[0], m[0] }, b = { m[1], m[1], m[1], m[1] };
+				const v4d		c = { m[2], m[2], m[2], m[2] }, d = { m[3], m[3], m[3], m[3] };
+				const v4d		e = { m[4], m[4], m[4], m[4] }, f = { m[5], m[5], m[5], m[5] };
+				const v4d		g = { m[6], m[6], m[6], m[6] }, h = { m[7], m[7], m[7], m[7] };
+				v4d				_sx = { 0, 0, 0, 0 }, _sxx = _sx, _sy = _sx, _syy = _sx;
+				double*			_sum = &_sums[((size_t)t*_monitors + k)*4];
+
+				for(i=p;i<p+n;i+=4) {
+					v4d x, px, y, py, _out;
+
+					load_V4D(&x, _x+i);
+					load_V4D(&px, _px+i);
+					load_V4D(&y, _y+i);
+					load_V4D(&py, _py+i);
+					_sx += x;
+					_sxx += x*x;
+					_sy += y;
+					_syy += y*y;
+					_out = a*x + b*px;	store_V4D(_x+i, &_out);
+					_out = c*x + d*px;	store_V4D(_px+i, &_out);
+					_out = e*y + f*py;	store_V4D(_y+i, &_out);
+					_out = g*y + h*py;	store_V4D(_py+i, &_out);
+				}
+				_sum[0] += sum_V4D(&_sx);
+				_sum[1] += sum_V4D(&_sxx);
+				_sum[2] += sum_V4D(&_sy);
+				_sum[3] += sum_V4D(&_syy);
+			}
+		}
+	}
+}
+
+/** Function to merge the sums of all the threads into the table and publish the turns (only
+ *  one thread, between the two barriers of a block) */
+static void publish_Turns(LHC_Tracker *_tracker, unsigned int _turn, unsigned int _turns) {
+
+	const unsigned int	_monitors = _tracker->_number_Of_Monitors;
+	const size_t		_stride = (size_t)TRACK_TURNS*_monitors*4;
+	const double		n = _tracker->_number_Of_Particles;
+	unsigned int		t, k, j;
+
+	for(t=0;t<_turns;t++) {
+		for(k=0;k<_monitors;k++) {
+			LHC_Beam_Position*	_position = &_tracker->_table[(size_t)(_turn+t)*_monitors + k];
+			double				s[4] = { 0, 0, 0, 0 }, _mean_X, _mean_Y;
+			const double*		_sum = &_tracker->_sums[((size_t)t*_monitors + k)*4];
+
+			for(j=0;j<_tracker->_number_Of_Threads;j++, _sum+=_stride) {
+				s[0] += _sum[0];
+				s[1] += _sum[1];
+				s[2] += _sum[2];
+				s[3] += _sum[3];
+			}
+			_mean_X = s[0]/n;
+			_mean_Y = s[2]/n;
+			_position->_mean_X = (float)(1e3*_mean_X);
+			_position->_mean_Y = (float)(1e3*_mean_Y);
+			_position->_sigma_X = (float)(1e3*sqrt(fmax(s[1]/n - _mean_X*_mean_X, 0.0)));
+			_position->_sigma_Y = (float)(1e3*sqrt(fmax(s[3]/n - _mean_Y*_mean_Y, 0.0)));
+		}
+	}
+
+	pthread_mutex_lock(&_tracker->_mutex);
+	if(_tracker->_stop || _turn+_turns >= _tracker->_number_Of_Turns) {
+		_tracker->_finished = 1;
+		_tracker->_end = monotonic_Now();
+	}
+	__atomic_store_n(&_tracker->_tracked, _turn+_turns, __ATOMIC_RELEASE);
+	pthread_cond_broadcast(&_tracker->_progress);
+	pthread_mutex_unlock(&_tracker->_mutex);
+}
+
+/** Tracking thread: owns one slice of the particles for the whole run */
+static void* tracking_Worker(void *_arg) {
+
+	LHC_Tracker*	_tracker = ( LHC_Tracker* ) _arg;
+	const size_t	_stride = (size_t)TRACK_TURNS*_tracker->_number_Of_Monitors*4;
+	unsigned int	_index, _slice, _first, _count=0, _turn, _turns;
+	double*			_sums;
+
+	pthread_mutex_lock(&_tracker->_mutex);
+	while(!_tracker->_go && !_tracker->_stop) pthread_cond_wait(&_tracker->_progress, &_tracker->_mutex);
+	if(!_tracker->_go) {
+		pthread_mutex_unlock(&_tracker->_mutex);
+		return NULL;
+	}
+	_index = _tracker->_go++ - 1;
+	pthread_mutex_unlock(&_tracker->_mutex);
+
+	/** Slices of a multiple of 4 particles */
+	_slice = ((_tracker->_number_Of_Particles/4 + _tracker->_number_Of_Threads-1)/_tracker->_number_Of_Threads)*4;
+	_first = _index*_slice;
+	if(_first < _tracker->_number_Of_Particles)
+		_count = (_tracker->_number_Of_Particles-_first < _slice) ? _tracker->_number_Of_Particles-_first : _slice;
+	_sums = _tracker->_sums + _index*_stride;
+
+	for(_turn=0;_turn<_tracker->_number_Of_Turns;_turn+=_turns) {
+		_turns = (_tracker->_number_Of_Turns-_turn < TRACK_TURNS) ? _tracker->_number_Of_Turns-_turn : TRACK_TURNS;
+		memset(_sums, 0, _stride*sizeof(double));
+		track_Particles(_tracker, _first, _count, _turns, _sums);
+
+		if(pthread_barrier_wait(&_tracker->_barrier)==PTHREAD_BARRIER_SERIAL_THREAD)
+			publish_Turns(_tracker, _turn, _turns);
+		pthread_barrier_wait(&_tracker->_barrier);
+		if(_tracker->_finished) break;
+	}
+
+	return NULL;
+}
+
+/** Function to place the particles: a gaussian beam matched to the optics at the first
+ *  monitor, displaced by the injection error */
+static void inject_Beam(LHC_Tracker *_tracker, const LHC_Beam_Config *_beam, const LHC_Twiss *_twiss_X,
+		const LHC_Twiss *_twiss_Y, uint64_t _seed) {
+
+	double			_sx = sqrt(_beam->_emittance*_twiss_X->_beta), _spx = sqrt(_beam->_emittance/_twiss_X->_beta);
+	double			_sy = sqrt(_beam->_emittance*_twiss_Y->_beta), _spy = sqrt(_beam->_emittance/_twiss_Y->_beta);
+	double			g[4];
+	unsigned int	i, j;
+
+	for(i=0;i<_tracker->_number_Of_Particles;i++) {
+		for(j=0;j<4;j++) g[j] = hash_Gaussian(sensor_Hash(_seed, i, j, 0));
+		_tracker->_x[i] = _beam->_offset_X + _sx*g[0];
+		_tracker->_px[i] = _spx*(g[1] - _twiss_X->_alpha*g[0]);
+		_tracker->_y[i] = _beam->_offset_Y + _sy*g[2];
+		_tracker->_py[i] = _spy*(g[3] - _twiss_Y->_alpha*g[2]);
+	}
+}
+
+/** Function to free a tracker whose threads are over */
+static void free_Tracker(LHC_Tracker *_tracker) {
+
+	pthread_cond_destroy(&_tracker->_progress);
+	pthread_mutex_destroy(&_tracker->_mutex);
+	free(_tracker->_threads);
+	free(_tracker->_sums);
+	free(_tracker->_table);
+	free(_tracker->_x);
+	free(_tracker->_px);
+	free(_tracker->_y);
+	free(_tracker->_py);
+	free(_tracker->_maps);
+	free(_tracker->_positions);
+	free(_tracker);
+}
+
+LHC_Tracker* create_Tracker(const LHC_Lattice *_lattice, const LHC_Beam_Config *_beam, const float *_positions,
+		unsigned int _monitors, unsigned int _turns, uint64_t _seed) {
+
+	LHC_Tracker*	_tracker;
+	LHC_Twiss		_twiss_X, _twiss_Y;
+	unsigned int	i, _threads = _beam ? _beam->_threads : 0, _created=0;
+	size_t			_particles;
+	double			_mx[4], _my[4];
+	int				_error=0;
+
+	if(!_lattice || !_beam || _beam->_particles==0 || !_positions || _monitors==0 || _turns==0) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if(lattice_Twiss(_lattice, _positions[0], &_twiss_X, &_twiss_Y)!=0) return NULL;
+	if(_threads==0) _threads = (unsigned int)sysconf(_SC_NPROCESSORS_ONLN);
+	if(_threads==0) _threads = 1;
+
+	_tracker = ( LHC_Tracker* ) calloc( 1, sizeof( LHC_Tracker ) );
+	if(!_tracker) return NULL;
+	_tracker->_number_Of_Monitors = _monitors;
+	_tracker->_number_Of_Particles = (_beam->_particles+3)/4*4;
+	_tracker->_number_Of_Turns = _turns;
+	_tracker->_number_Of_Threads = _threads;
+	_particles = _tracker->_number_Of_Particles;
+
+	pthread_mutex_init(&_tracker->_mutex, NULL);
+	pthread_cond_init(&_tracker->_progress, NULL);
+	_tracker->_positions = ( float* ) malloc( _monitors*sizeof( float ) );
+	_tracker->_maps = ( double* ) malloc( (size_t)_monitors*8*sizeof( double ) );
+	_tracker->_x = ( double* ) malloc( _particles*sizeof( double ) );
+	_tracker->_px = ( double* ) malloc( _particles*sizeof( double ) );
+	_tracker->_y = ( double* ) malloc( _particles*sizeof( double ) );
+	_tracker->_py = ( double* ) malloc( _particles*sizeof( double ) );
+	_tracker->_table = ( LHC_Beam_Position* ) malloc( (size_t)_turns*_monitors*sizeof( LHC_Beam_Position ) );
+	_tracker->_sums = ( double* ) malloc( (size_t)_threads*TRACK_TURNS*_monitors*4*sizeof( double ) );
+	_tracker->_threads = ( pthread_t* ) calloc( _threads, sizeof( pthread_t ) );
+	if(!_tracker->_positions || !_tracker->_maps || !_tracker->_x || !_tracker->_px || !_tracker->_y ||
+			!_tracker->_py || !_tracker->_table || !_tracker->_sums || !_tracker->_threads) {
+		free_Tracker(_tracker);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	/** One map from every monitor to the next one */
+	memcpy(_tracker->_positions, _positions, _monitors*sizeof( float ));
+	for(i=0;i<_monitors;i++) {
+		lattice_Map(_lattice, _positions[i], _positions[(i+1)%_monitors], _mx, _my);
+		memcpy(&_tracker->_maps[i*8], _mx, sizeof(_mx));
+		memcpy(&_tracker->_maps[i*8+4], _my, sizeof(_my));
+	}
+	inject_Beam(_tracker, _beam, &_twiss_X, &_twiss_Y, _seed);
+
+	for(i=0;i<_threads;i++) {
+		_error = pthread_create(&_tracker->_threads[i], NULL, tracking_Worker, _tracker);
+		if(_error!=0) break;
+		_created++;
+	}
+
+	/** The threads only go once they are all there (the barrier counts them) */
+	pthread_mutex_lock(&_tracker->_mutex);
+	if(_created>0) {
+		_tracker->_number_Of_Threads = _created;
+		pthread_barrier_init(&_tracker->_barrier, NULL, _created);
+		_tracker->_begin = monotonic_Now();
+		_tracker->_go = 1;
+	} else _tracker->_stop = 1;
+	pthread_cond_broadcast(&_tracker->_progress);
+	pthread_mutex_unlock(&_tracker->_mutex);
+
+	if(_created==0) {
+		free_Tracker(_tracker);
+		errno = _error;
+		return NULL;
+	}
+	return _tracker;
+}
+
+unsigned int tracker_Monitor(const LHC_Tracker *_tracker, float _position) {
+
+	unsigned int k;
+
+	for(k=_tracker->_number_Of_Monitors;k>0;k--)
+		if(_tracker->_positions[k-1] <= _position) return k-1;
+	return _tracker->_number_Of_Monitors-1;
+}
+
+const LHC_Beam_Position* wait_Tracker(LHC_Tracker *_tracker, unsigned int _turn, unsigned int _monitor) {
+
+	if(__atomic_load_n(&_tracker->_tracked, __ATOMIC_ACQUIRE) <= _turn) {
+		pthread_mutex_lock(&_tracker->_mutex);
+		while(_tracker->_tracked <= _turn && !_tracker->_finished) pthread_cond_wait(&_tracker->_progress, &_tracker->_mutex);
+		pthread_mutex_unlock(&_tracker->_mutex);
+		if(__atomic_load_n(&_tracker->_tracked, __ATOMIC_ACQUIRE) <= _turn) return NULL;
+	}
+	return &_tracker->_table[(size_t)_turn*_tracker->_number_Of_Monitors + _monitor];
+}
+
+void destroy_Tracker(LHC_Tracker *_tracker) {
+
+	unsigned int i;
+
+	if(!_tracker) return;
+
+	pthread_mutex_lock(&_tracker->_mutex);
+	_tracker->_stop = 1;
+	pthread_mutex_unlock(&_tracker->_mutex);
+	for(i=0;i<_tracker->_number_Of_Threads;i++) pthread_join(_tracker->_threads[i], NULL);
+	pthread_barrier_destroy(&_tracker->_barrier);
+	free_Tracker(_tracker);
+}
@@ -0,0 +1,407 @@
+//==============================================================================//
+//  Filename: lhc_trigger.c														//
+//
+//==============================================================================//
+//																				//
+//  Description : Written in C, Ansi-style.										//
+//------------------------------------------------------------------------------//
+
+/* Local includes */
+#include "../include/lhc_trigger.h"
+#include "../include/lhc_format.h"
+#include "../include/lhc_sensor.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRIGGER_SALT 0x4c31547269676765ULL	/* Keeps the collisions apart from the sensors. */
+
+#define SOFT_ET 0.8f					/* Mean E_T of a soft collision (GeV). */
+#define SOFT_ET_SIGMA 0.6f				/* Its spread (GeV). */
+#define HARD_RATE 2e-5f					/* Hard processes per collision. */
+#define HARD_ET 60.0f					/* Minimum and slope of their E_T (GeV). */
+#define MUON_RATE 1e-4f					/* Muons per collision. */
+#define MUON_PT 3.0f					/* Minimum of their p_T (GeV). */
+#define MUON_SLOPE 8.0f					/* Slope of their p_T (GeV). */
+
+/** Random draws of a crossing (channel of sensor_Hash) */
+enum { DRAW_COLLISIONS = 0, DRAW_SOFT, DRAW_HARD, DRAW_HARD_ET, DRAW_MUON, DRAW_MUON_PT, DRAW_MISSING };
+
+
+/*  COLLISIONS  */
+/*~~~~~~~~~~~~~~*/
+unsigned int default_Interaction_Points(LHC_Interaction_Point *_points) {
+
+	/** IP1, IP2, IP5 and IP8: ALICE runs at a much lower luminosity */
+	static const LHC_Interaction_Point _lhc[] = {
+		{     0.0f, 2808, 50.0f },		/* ATLAS */
+		{  3332.0f, 2808, 0.02f },		/* ALICE */
+		{ 13329.5f, 2808, 50.0f },		/* CMS */
+		{ 23326.0f, 2808, 5.0f }		/* LHCb */
+	};
+
+	memcpy(_points, _lhc, sizeof(_lhc));
+	return sizeof(_lhc)/sizeof(_lhc[0]);
+}
+
+void default_Trigger_Menu(LHC_Trigger_Menu *_menu) {
+	_menu->_et_Threshold = 120.0f;
+	_menu->_muon_Threshold = 20.0f;
+	_menu->_prescale = 10000;
+}
+
+/** Every crossing draws its own numbers from (seed, interaction point, crossing, revolution):
+ *  the soft collisions give a gaussian E_T, rare hard processes and muons have exponential
+ *  tails (only those few take a logarithm). */
+void generate_Collisions(const LHC_Interaction_Point *_point, unsigned int _ip, uint64_t _seed, unsigned int _turn, LHC_Burst *_burst) {
+
+	unsigned int	_bunches = (_point->_bunches < LHC_BUNCH_SLOTS) ? _point->_bunches : LHC_BUNCH_SLOTS;
+	float			_pile_Up = _point->_pile_Up, _spread = sqrtf(_point->_pile_Up);
+	unsigned int	k;
+
+	_seed ^= TRIGGER_SALT;
+	for(k=0;k<_bunches;k++) {
+		LHC_Event*	_event = &_burst->_events[k];
+		uint32_t	_id = (_ip<<12) | k;
+		float		n = floorf(_pile_Up + _spread*hash_Gaussian(sensor_Hash(_seed, _id, DRAW_COLLISIONS, _turn)) + 0.5f);
+		float		_et, _pt=0.0f;
+		unsigned int _muons=0;
+
+		if(n<0.0f) n = 0.0f;
+		_et = n*SOFT_ET + sqrtf(n)*SOFT_ET_SIGMA*hash_Gaussian(sensor_Hash(_seed, _id, DRAW_SOFT, _turn));
+		if(_et<0.0f) _et = 0.0f;
+
+		if(hash_Uniform(sensor_Hash(_seed, _id, DRAW_HARD, _turn)) < HARD_RATE*n)
+			_et += HARD_ET*(1.0f - logf(1.0f - hash_Uniform(sensor_Hash(_seed, _id, DRAW_HARD_ET, _turn))));
+		if(hash_Uniform(sensor_Hash(_seed, _id, DRAW_MUON, _turn)) < MUON_RATE*n) {
+			_muons = 1;
+			_pt = MUON_PT - MUON_SLOPE*logf(1.0f - hash_Uniform(sensor_Hash(_seed, _id, DRAW_MUON_PT, _turn)));
+		}
+
+		_event->_turn = _turn;
+		_event->_crossing = (uint16_t)k;
+		_event->_ip = (uint8_t)_ip;
+		_event->_muons = (uint8_t)_muons;
+		_event->_collisions = (uint16_t)n;
+		_event->_trigger = 0;
+		_event->_sum_Et = _et;
+		_event->_muon_Pt = _pt;
+		_event->_missing_Et = 0.5f*sqrtf(_et)*fabsf(hash_Gaussian(sensor_Hash(_seed, _id, DRAW_MISSING, _turn)));
+	}
+	_burst->_ip = _ip;
+	_burst->_number_Of_Events = _bunches;
+}
+
+
+/*  DECISION  */
+/*~~~~~~~~~~~~*/
+/** Nearly every event is rejected, so there is no branch per event: every event is copied to
+ *  the end of the kept ones, and the end only moves when the event is kept. */
+unsigned int decide_Burst(const LHC_Trigger_Menu *_menu, LHC_Burst *_burst) {
+
+	LHC_Event*		_events = _burst->_events;
+	const float		_et = _menu->_et_Threshold, _pt = _menu->_muon_Threshold;
+	const uint64_t	_prescale = _menu->_prescale ? _menu->_prescale : 1;
+	const unsigned int _prescaled = (_menu->_prescale!=0);
+	unsigned int	k, _kept=0, _bits;
+
+	for(k=0;k<_burst->_number_Of_Events;k++) {
+		uint64_t _crossing = (uint64_t)_events[k]._turn*LHC_BUNCH_SLOTS + _events[k]._crossing;
+
+		_bits = (unsigned int)(_events[k]._sum_Et > _et)*LHC_TRIGGER_ET |
+				(unsigned int)(_events[k]._muon_Pt > _pt)*LHC_TRIGGER_MUON |
+				(_prescaled & (unsigned int)(_crossing%_prescale==0))*LHC_TRIGGER_PRESCALE;
+		_events[k]._trigger = (uint16_t)_bits;
+		_events[_kept] = _events[k];
+		_kept += (_bits!=0);
+	}
+	_burst->_number_Of_Events = _kept;
+
+	return _kept;
+}
+
+/** Function to write the line of a kept event:
+ *  "turn:ip;crossing;collisions;muons;sum_Et;muon_Pt;missing_Et;trigger.\n" */
+static size_t format_Event_Line(char *_line, const LHC_Event *_event) {
+
+	char* p = _line;
+
+	p += format_Int(p, (int)_event->_turn);			*p++ = ':';
+	p += format_Int(p, _event->_ip);				*p++ = ';';
+	p += format_Int(p, _event->_crossing);			*p++ = ';';
+	p += format_Int(p, _event->_collisions);		*p++ = ';';
+	p += format_Int(p, _event->_muons);				*p++ = ';';
+	p += format_Float(p, _event->_sum_Et);			*p++ = ';';
+	p += format_Float(p, _event->_muon_Pt);			*p++ = ';';
+	p += format_Float(p, _event->_missing_Et);		*p++ = ';';
+	p += format_Int(p, _event->_trigger);			*p++ = '.';
+	*p++ = '\n';
+
+	return (size_t)(p - _line);
+}
+
+
+/*  STATISTICS  */
+/*~~~~~~~~~~~~~~*/
+void clear_Trigger_Stats(LHC_Trigger_Stats *_stats) {
+
+	memset(_stats, 0, sizeof(LHC_Trigger_Stats));
+	_stats->_latency_Min = INT64_MAX;
+	_stats->_latency_Max = INT64_MIN;
+}
+
+void merge_Trigger_Stats(LHC_Trigger_Stats *_total, const LHC_Trigger_Stats *_stats) {
+
+	unsigned int b;
+
+	_total->_bursts += _stats->_bursts;
+	_total->_events += _stats->_events;
+	_total->_accepted += _stats->_accepted;
+	_total->_accepted_Et += _stats->_accepted_Et;
+	_total->_accepted_Muon += _stats->_accepted_Muon;
+	_total->_accepted_Prescale += _stats->_accepted_Prescale;
+	_total->_latency_Sum += _stats->_latency_Sum;
+	_total->_decision_Time += _stats->_decision_Time;
+	if(_stats->_latency_Min < _total->_latency_Min) _total->_latency_Min = _stats->_latency_Min;
+	if(_stats->_latency_Max > _total->_latency_Max) _total->_latency_Max = _stats->_latency_Max;
+	for(b=0;b<LHC_PACING_BUCKETS;b++) _total->_latency_Histogram[b] += _stats->_latency_Histogram[b];
+}
+
+void print_Trigger_Stats(FILE *_fp, const LHC_Trigger_Stats *_stats, double _seconds) {
+
+	fprintf(_fp, "Level-1 trigger:");
+	if(_stats->_bursts==0) {
+		fprintf(_fp, " no bursts.\n");
+		return;
+	}
+	fprintf(_fp, " %lu bursts, %lu events, %lu kept (%lu E_T, %lu muon, %lu prescaled), rejection %.0f:1.\n",
+			_stats->_bursts, _stats->_events, _stats->_accepted, _stats->_accepted_Et,
+			_stats->_accepted_Muon, _stats->_accepted_Prescale,
+			_stats->_accepted ? (double)_stats->_events/_stats->_accepted : (double)_stats->_events);
+	fprintf(_fp, "  throughput %.3g events/s over the run, %.3g events/s per busy worker.\n",
+			_seconds>0 ? _stats->_events/_seconds : 0.0,
+			_stats->_decision_Time>0 ? _stats->_events/(_stats->_decision_Time*1e-9) : 0.0);
+	fprintf(_fp, "  latency min %lld / mean %.0f / max %lld ns.\n", (long long)_stats->_latency_Min,
+			_stats->_latency_Sum/_stats->_bursts, (long long)_stats->_latency_Max);
+	print_Histogram(_fp, "latency", _stats->_latency_Histogram);
+}
+
+
+/*  WORKERS  */
+/*~~~~~~~~~~~*/
+/** Function to account the decision of a burst */
+static void count_Burst(LHC_Trigger_Stats *_stats, const LHC_Burst *_burst, unsigned int _events, int64_t _start, int64_t _end) {
+
+	int64_t			_latency = _end - _burst->_time;
+	unsigned int	k;
+
+	_stats->_bursts++;
+	_stats->_events += _events;
+	_stats->_accepted += _burst->_number_Of_Events;
+	for(k=0;k<_burst->_number_Of_Events;k++) {
+		_stats->_accepted_Et += (_burst->_events[k]._trigger & LHC_TRIGGER_ET)!=0;
+		_stats->_accepted_Muon += (_burst->_events[k]._trigger & LHC_TRIGGER_MUON)!=0;
+		_stats->_accepted_Prescale += (_burst->_events[k]._trigger & LHC_TRIGGER_PRESCALE)!=0;
+	}
+	if(_latency < _stats->_latency_Min) _stats->_latency_Min = _latency;
+	if(_latency > _stats->_latency_Max) _stats->_latency_Max = _latency;
+	_stats->_latency_Sum += _latency;
+	_stats->_latency_Histogram[pacing_Bucket(_latency)]++;
+	_stats->_decision_Time += _end - _start;
+}
+
+/** Worker thread: takes the bursts in order of arrival until the trigger stops and the queue
+ *  is empty. Kept events go to its own buffer, handed to the engine once full. */
+static void* trigger_Worker(void *_arg) {
+
+	LHC_Trigger*		_trigger = ( LHC_Trigger* ) _arg;
+	LHC_Burst*			_burst;
+	LHC_IO_Buffer*		_buffer = NULL;
+	LHC_Trigger_Stats	_stats;
+	unsigned int		_events, k;
+	int64_t				_start, _end;
+
+	clear_Trigger_Stats(&_stats);
+	if(_trigger->_io) _buffer = get_IO_Buffer(_trigger->_io);
+
+	for(;;) {
+		pthread_mutex_lock(&_trigger->_mutex);
+		while(!_trigger->_queue_Head && !_trigger->_stop) pthread_cond_wait(&_trigger->_work, &_trigger->_mutex);
+		_burst = _trigger->_queue_Head;
+		if(!_burst) {
+			pthread_mutex_unlock(&_trigger->_mutex);
+			break;
+		}
+		_trigger->_queue_Head = _burst->_next;
+		if(!_trigger->_queue_Head) _trigger->_queue_Tail = NULL;
+		pthread_mutex_unlock(&_trigger->_mutex);
+
+		_start = monotonic_Now();
+		_events = _burst->_number_Of_Events;
+		decide_Burst(&_trigger->_menu, _burst);
+		_end = monotonic_Now();
+		count_Burst(&_stats, _burst, _events, _start, _end);
+
+		for(k=0;_buffer && k<_burst->_number_Of_Events;k++) {
+			if(_buffer->_size - _buffer->_length < LHC_FORMAT_LINE_MAX) {
+				submit_IO_Buffer(_trigger->_io, _trigger->_file, _buffer);
+				_buffer = get_IO_Buffer(_trigger->_io);
+			}
+			_buffer->_length += format_Event_Line(_buffer->_data + _buffer->_length, &_burst->_events[k]);
+		}
+
+		/** The burst goes back to the pool */
+		pthread_mutex_lock(&_trigger->_mutex);
+		_burst->_next = _trigger->_free;
+		_trigger->_free = _burst;
+		pthread_cond_signal(&_trigger->_done);
+		pthread_mutex_unlock(&_trigger->_mutex);
+	}
+	if(_buffer) submit_IO_Buffer(_trigger->_io, _trigger->_file, _buffer);
+
+	pthread_mutex_lock(&_trigger->_mutex);
+	merge_Trigger_Stats(&_trigger->_stats, &_stats);
+	pthread_mutex_unlock(&_trigger->_mutex);
+
+	return NULL;
+}
+
+/** Function to stop the workers once the queue is empty and wait for them */
+static void stop_Workers(LHC_Trigger *_trigger, unsigned int _workers) {
+
+	unsigned int i;
+
+	pthread_mutex_lock(&_trigger->_mutex);
+	_trigger->_stop = 1;
+	pthread_cond_broadcast(&_trigger->_work);
+	pthread_mutex_unlock(&_trigger->_mutex);
+	for(i=0;i<_workers;i++) pthread_join(_trigger->_workers[i], NULL);
+}
+
+/** Function to free a trigger whose workers are over */
+static int free_Trigger(LHC_Trigger *_trigger) {
+
+	int _error = 0;
+
+	if(_trigger->_file) _error = close_IO_File(_trigger->_io, _trigger->_file);
+	pthread_cond_destroy(&_trigger->_done);
+	pthread_cond_destroy(&_trigger->_work);
+	pthread_mutex_destroy(&_trigger->_mutex);
+	free(_trigger->_workers);
+	free(_trigger->_memory);
+	free(_trigger->_bursts);
+	free(_trigger);
+
+	return _error;
+}
+
+
+/*  TRIGGER  */
+/*~~~~~~~~~~~*/
+LHC_Trigger* create_Trigger(const LHC_Trigger_Menu *_menu, unsigned int _workers, unsigned int _bursts,
+		LHC_IO_Engine *_io, const char *_name) {
+
+	LHC_Trigger*	_trigger;
+	unsigned int	i;
+	int				_error=0;
+
+	if(!_menu || _workers==0 || _bursts==0 || (_io && !_name)) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	_trigger = ( LHC_Trigger* ) calloc( 1, sizeof( LHC_Trigger ) );
+	if(!_trigger) return NULL;
+	_trigger->_menu = *_menu;
+	_trigger->_number_Of_Bursts = _bursts;
+	_trigger->_io = _io;
+	clear_Trigger_Stats(&_trigger->_stats);
+
+	/** Pool of bursts: the events of each one are a slice of one single allocation */
+	_trigger->_bursts = ( LHC_Burst* ) calloc( _bursts, sizeof( LHC_Burst ) );
+	_trigger->_memory = ( LHC_Event* ) malloc( (size_t)_bursts*LHC_BUNCH_SLOTS*sizeof( LHC_Event ) );
+	_trigger->_workers = ( pthread_t* ) calloc( _workers, sizeof( pthread_t ) );
+	if(!_trigger->_bursts || !_trigger->_memory || !_trigger->_workers) {
+		free(_trigger->_workers);
+		free(_trigger->_memory);
+		free(_trigger->_bursts);
+		free(_trigger);
+		errno = ENOMEM;
+		return NULL;
+	}
+	for(i=0;i<_bursts;i++) {
+		_trigger->_bursts[i]._events = _trigger->_memory + (size_t)i*LHC_BUNCH_SLOTS;
+		_trigger->_bursts[i]._next = (i+1<_bursts) ? &_trigger->_bursts[i+1] : NULL;
+	}
+	_trigger->_free = _trigger->_bursts;
+
+	pthread_mutex_init(&_trigger->_mutex, NULL);
+	pthread_cond_init(&_trigger->_work, NULL);
+	pthread_cond_init(&_trigger->_done, NULL);
+
+	if(_io) {
+		_trigger->_file = open_IO_File(_io, _name);
+		if(!_trigger->_file) {
+			_error = errno;
+			free_Trigger(_trigger);
+			errno = _error;
+			return NULL;
+		}
+	}
+
+	for(i=0;i<_workers;i++) {
+		_error = pthread_create(&_trigger->_workers[i], NULL, trigger_Worker, _trigger);
+		if(_error!=0) break;
+	}
+	_trigger->_number_Of_Workers = i;
+	if(_error!=0) {
+		stop_Workers(_trigger, i);
+		free_Trigger(_trigger);
+		errno = _error;
+		return NULL;
+	}
+
+	return _trigger;
+}
+
+LHC_Burst* get_Trigger_Burst(LHC_Trigger *_trigger) {
+
+	LHC_Burst* _burst;
+
+	pthread_mutex_lock(&_trigger->_mutex);
+	while(!_trigger->_free) pthread_cond_wait(&_trigger->_done, &_trigger->_mutex);
+	_burst = _trigger->_free;
+	_trigger->_free = _burst->_next;
+	pthread_mutex_unlock(&_trigger->_mutex);
+
+	_burst->_next = NULL;
+	_burst->_number_Of_Events = 0;
+
+	return _burst;
+}
+
+void submit_Trigger_Burst(LHC_Trigger *_trigger, LHC_Burst *_burst) {
+
+	pthread_mutex_lock(&_trigger->_mutex);
+	_burst->_next = NULL;
+	if(_trigger->_queue_Tail) _trigger->_queue_Tail->_next = _burst;
+	else 					  _trigger->_queue_Head = _burst;
+	_trigger->_queue_Tail = _burst;
+	pthread_cond_signal(&_trigger->_work);
+	pthread_mutex_unlock(&_trigger->_mutex);
+}
+
+int destroy_Trigger(LHC_Trigger *_trigger, LHC_Trigger_Stats *_stats) {
+
+	int _error;
+
+	if(!_trigger) return 0;
+
+	stop_Workers(_trigger, _trigger->_number_Of_Workers);
+	if(_stats) *_stats = _trigger->_stats;
+	_error = free_Trigger(_trigger);
+
+	return _error;
+}